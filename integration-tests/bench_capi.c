@@ -0,0 +1,278 @@
+/* Chunk-throughput microbenchmark for the C extension API layer.
+ *
+ * The Python perf scripts (perf_all_modes.py and friends) measure end-to-end
+ * query latency; this binary isolates the cost of the bridge itself - the
+ * per-chunk crossing of duckdb_capi/duckdb.h and the per-row string
+ * materialization through duckdb_vector_assign_string_element - by driving
+ * synthetic string tables of varying widths through the cheapest function
+ * each extension exposes (no model inference, no Graal compute). Comparing
+ * against the built-in baseline queries gives the bridge overhead; tracking
+ * the numbers release over release catches regressions in the C API glue.
+ *
+ * Every allocation in the process is counted via malloc interposition, so
+ * each benchmark also reports allocations per 1000 rows - the chunk-size and
+ * string-materialization costs show up there even when wall time is noisy.
+ *
+ * Build and run through the Makefile: make bench-capi. Extension paths come
+ * from AI_EXT / ATLAS_EXT / CQL2ELM_EXT; missing extensions are skipped.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "duckdb.h"
+
+/* ---- allocation counting -------------------------------------------------
+ * Strong definitions here interpose over libc for the whole process,
+ * libduckdb and extensions included. dlsym(RTLD_NEXT) can itself allocate
+ * before the real functions are resolved; a small static arena serves those
+ * bootstrap calls (and their frees are ignored). */
+
+static atomic_ullong bench_alloc_count;
+
+static void *(*real_malloc)(size_t) = NULL;
+static void *(*real_calloc)(size_t, size_t) = NULL;
+static void *(*real_realloc)(void *, size_t) = NULL;
+static void (*real_free)(void *) = NULL;
+
+static char bootstrap_arena[65536];
+static size_t bootstrap_used = 0;
+
+static int in_bootstrap(const void *ptr) {
+    const char *p = (const char *)ptr;
+    return p >= bootstrap_arena && p < bootstrap_arena + sizeof(bootstrap_arena);
+}
+
+/* Each block carries a 16-byte size header so a later realloc knows how
+ * many bytes may be copied out of the arena. Keeps 16-byte alignment. */
+static void *bootstrap_alloc(size_t size) {
+    size_t total = 16 + ((size + 15) & ~(size_t)15);
+    if (bootstrap_used + total > sizeof(bootstrap_arena)) return NULL;
+    char *block = bootstrap_arena + bootstrap_used;
+    bootstrap_used += total;
+    *(size_t *)block = size;
+    return block + 16;
+}
+
+static size_t bootstrap_size(const void *ptr) {
+    return *(const size_t *)((const char *)ptr - 16);
+}
+
+static void resolve_real(void) {
+    static atomic_flag resolving = ATOMIC_FLAG_INIT;
+    if (atomic_flag_test_and_set(&resolving)) return; /* re-entered via dlsym */
+    real_malloc = (void *(*)(size_t))dlsym(RTLD_NEXT, "malloc");
+    real_calloc = (void *(*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+    real_realloc = (void *(*)(void *, size_t))dlsym(RTLD_NEXT, "realloc");
+    real_free = (void (*)(void *))dlsym(RTLD_NEXT, "free");
+}
+
+void *malloc(size_t size) {
+    if (!real_malloc) {
+        resolve_real();
+        if (!real_malloc) return bootstrap_alloc(size);
+    }
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return real_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (!real_calloc) {
+        resolve_real();
+        if (!real_calloc) {
+            void *ptr = bootstrap_alloc(count * size);
+            if (ptr) memset(ptr, 0, count * size);
+            return ptr;
+        }
+    }
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return real_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (!real_realloc) {
+        resolve_real();
+        if (!real_realloc) return NULL;
+    }
+    if (in_bootstrap(ptr)) {
+        void *fresh = real_malloc(size);
+        if (fresh) {
+            size_t old = bootstrap_size(ptr);
+            memcpy(fresh, ptr, old < size ? old : size);
+        }
+        return fresh;
+    }
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return real_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    if (!ptr || in_bootstrap(ptr)) return;
+    if (!real_free) resolve_real();
+    if (real_free) real_free(ptr);
+}
+
+/* ---- benchmark harness -------------------------------------------------- */
+
+#define BENCH_ROWS 200000
+#define BENCH_ITERATIONS 10
+#define BENCH_WARMUP 2
+
+static const int bench_widths[] = {8, 64, 512};
+#define BENCH_WIDTH_COUNT (sizeof(bench_widths) / sizeof(bench_widths[0]))
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* Runs sql and discards the result; exits loudly on error so a broken
+ * extension does not produce silently wrong numbers. */
+static void must_query(duckdb_connection conn, const char *sql) {
+    duckdb_result result;
+    if (duckdb_query(conn, sql, &result) != DuckDBSuccess) {
+        fprintf(stderr, "query failed: %s\n%s\n", sql, duckdb_result_error(&result));
+        duckdb_destroy_result(&result);
+        exit(1);
+    }
+    duckdb_destroy_result(&result);
+}
+
+static int try_load_extension(duckdb_connection conn, const char *env_name) {
+    const char *path = getenv(env_name);
+    if (!path || !*path) {
+        printf("# %s not set, skipping\n", env_name);
+        return 0;
+    }
+    char sql[1024];
+    snprintf(sql, sizeof(sql), "LOAD '%s'", path);
+    duckdb_result result;
+    if (duckdb_query(conn, sql, &result) != DuckDBSuccess) {
+        printf("# %s failed to load (%s), skipping\n", env_name, duckdb_result_error(&result));
+        duckdb_destroy_result(&result);
+        return 0;
+    }
+    duckdb_destroy_result(&result);
+    return 1;
+}
+
+/* Times a query over a BENCH_ROWS-row table: median wall time over
+ * BENCH_ITERATIONS runs after BENCH_WARMUP, plus the process-wide
+ * allocation count of the median run. */
+static void bench(duckdb_connection conn, const char *label, int width, const char *sql) {
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        must_query(conn, sql);
+    }
+
+    double times[BENCH_ITERATIONS];
+    unsigned long long allocs[BENCH_ITERATIONS];
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        unsigned long long allocs_before = atomic_load(&bench_alloc_count);
+        double t0 = now_ms();
+        must_query(conn, sql);
+        times[i] = now_ms() - t0;
+        allocs[i] = atomic_load(&bench_alloc_count) - allocs_before;
+    }
+
+    /* Median by insertion sort; the paired alloc count travels with it. */
+    for (int i = 1; i < BENCH_ITERATIONS; i++) {
+        double t = times[i];
+        unsigned long long a = allocs[i];
+        int j = i - 1;
+        while (j >= 0 && times[j] > t) {
+            times[j + 1] = times[j];
+            allocs[j + 1] = allocs[j];
+            j--;
+        }
+        times[j + 1] = t;
+        allocs[j + 1] = a;
+    }
+    double median_ms = times[BENCH_ITERATIONS / 2];
+    unsigned long long median_allocs = allocs[BENCH_ITERATIONS / 2];
+
+    printf("%-28s %5d  %10.2f  %12.0f  %10.1f\n", label, width, median_ms,
+           BENCH_ROWS / (median_ms / 1000.0),
+           (double)median_allocs * 1000.0 / BENCH_ROWS);
+}
+
+int main(void) {
+    duckdb_config config;
+    duckdb_database db;
+    duckdb_connection conn;
+    char *open_error = NULL;
+
+    if (duckdb_create_config(&config) != DuckDBSuccess ||
+        duckdb_set_config(config, "allow_unsigned_extensions", "true") != DuckDBSuccess) {
+        fprintf(stderr, "failed to create config\n");
+        return 1;
+    }
+    if (duckdb_open_ext(NULL, &db, config, &open_error) != DuckDBSuccess) {
+        fprintf(stderr, "failed to open database: %s\n", open_error ? open_error : "?");
+        return 1;
+    }
+    duckdb_destroy_config(&config);
+    if (duckdb_connect(db, &conn) != DuckDBSuccess) {
+        fprintf(stderr, "failed to connect\n");
+        return 1;
+    }
+
+    int have_ai = try_load_extension(conn, "AI_EXT");
+    int have_atlas = try_load_extension(conn, "ATLAS_EXT");
+    int have_cql2elm = try_load_extension(conn, "CQL2ELM_EXT");
+
+    for (size_t w = 0; w < BENCH_WIDTH_COUNT; w++) {
+        char sql[512];
+        snprintf(sql, sizeof(sql),
+                 "CREATE TABLE strings_%d AS "
+                 "SELECT repeat('x', %d) || range::VARCHAR AS s FROM range(%d)",
+                 bench_widths[w], bench_widths[w], BENCH_ROWS);
+        must_query(conn, sql);
+    }
+
+    printf("# %d rows per query, median of %d runs\n", BENCH_ROWS, BENCH_ITERATIONS);
+    printf("%-28s %5s  %10s  %12s  %10s\n", "benchmark", "width", "median_ms", "rows_per_sec",
+           "allocs_1k");
+
+    for (size_t w = 0; w < BENCH_WIDTH_COUNT; w++) {
+        int width = bench_widths[w];
+        char sql[512];
+
+        /* Baselines: chunk scan without per-row strings, then a built-in
+         * string function that materializes one output string per row. */
+        snprintf(sql, sizeof(sql), "SELECT count(*) FROM strings_%d", width);
+        bench(conn, "baseline_scan", width, sql);
+        snprintf(sql, sizeof(sql), "SELECT max(upper(s)) FROM strings_%d", width);
+        bench(conn, "baseline_builtin_string", width, sql);
+
+        /* Extension scalar functions: per-row string in, per-row string out
+         * through duckdb_vector_assign_string_element, no heavy compute. */
+        if (have_ai) {
+            snprintf(sql, sizeof(sql), "SELECT max(trex_ai(s)) FROM strings_%d", width);
+            bench(conn, "ai_bridge_scalar", width, sql);
+        }
+        if (have_atlas) {
+            snprintf(sql, sizeof(sql), "SELECT max(trex_atlas_hello(s)) FROM strings_%d", width);
+            bench(conn, "atlas_bridge_scalar", width, sql);
+        }
+    }
+
+    /* Table-function bridge: an empty trace snapshot measures bind/init/
+     * chunk-loop crossing with no payload. */
+    if (have_cql2elm) {
+        bench(conn, "cql2elm_bridge_table_fn", 0, "SELECT count(*) FROM trex_fhir_cql_trace()");
+    }
+    if (have_ai) {
+        bench(conn, "ai_bridge_table_fn", 0, "SELECT count(*) FROM trex_ai_trace()");
+    }
+
+    duckdb_disconnect(&conn);
+    duckdb_close(&db);
+    return 0;
+}
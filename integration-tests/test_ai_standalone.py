@@ -6,6 +6,8 @@ Verifies that the ai extension can load, report status/GPU info, and
 
 import os
 import shutil
+import time
+
 import pytest
 from conftest import AI_EXT, REPO_ROOT, Node, alloc_ports
 
@@ -47,6 +49,19 @@ def _ensure_model_available():
     return None
 
 
+def _wait_until_ready(node, model_name, timeout=AI_TIMEOUT):
+    """Model loads are asynchronous; poll trex_ai_load_status until ready."""
+    deadline = time.time() + timeout
+    status = "unknown"
+    while time.time() < deadline:
+        status = node.execute(f"SELECT trex_ai_load_status('{model_name}')")[0][0]
+        if status == "ready":
+            return
+        assert not status.startswith("failed"), status
+        time.sleep(0.5)
+    pytest.fail(f"model '{model_name}' not ready after {timeout}s (last status: {status})")
+
+
 # ---------------------------------------------------------------------------
 # Model-free tests (fast, no network)
 # ---------------------------------------------------------------------------
@@ -127,7 +142,8 @@ class TestAiWithModel:
             f"SELECT trex_ai_load_model('{model_path}', '{MODEL_LOAD_CONFIG}')",
             timeout=AI_TIMEOUT,
         )
-        assert "success" in result[0][0]
+        assert "loading" in result[0][0], result[0][0]
+        _wait_until_ready(ai_node, MODEL_NAME)
 
         result = ai_node.execute("SELECT trex_ai_list_loaded()")
         assert MODEL_NAME in result[0][0] or MODEL_FILENAME in result[0][0]
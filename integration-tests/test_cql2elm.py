@@ -72,3 +72,76 @@ def test_invalid_cql(cql2elm_node):
     """Invalid CQL syntax raises an error."""
     with pytest.raises(RuntimeError, match="(?i)(error|translation)"):
         cql2elm_node.execute("SELECT trex_fhir_cql_translate('this is not valid CQL at all')")
+
+
+def _library(name, body="define One: 1", includes=()):
+    """Builds a minimal CQL library, optionally including other libraries."""
+    parts = [f"library {name} version '1.0.0'", "using FHIR version '4.0.1'"]
+    for inc in includes:
+        parts.append(f"include {inc} version '1.0.0' called {inc}")
+    parts.append("context Patient")
+    parts.append(body)
+    return " ".join(parts)
+
+
+def _bulk_sql(libs):
+    names = ", ".join(f"'{_sql_escape(n)}'" for n, _ in libs)
+    cqls = ", ".join(f"'{_sql_escape(c)}'" for _, c in libs)
+    return f"SELECT name, elm_json FROM trex_fhir_cql_translate_bulk([{names}], [{cqls}])"
+
+
+def test_bulk_independent_libraries(cql2elm_node):
+    """Independent libraries all translate and each row carries valid ELM."""
+    libs = [(f"Bulk{i}", _library(f"Bulk{i}")) for i in range(4)]
+    result = cql2elm_node.execute(_bulk_sql(libs))
+    assert sorted(row[0] for row in result) == sorted(n for n, _ in libs)
+    for name, elm_json in result:
+        elm = json.loads(elm_json)
+        lib = elm.get("library", elm)
+        assert lib["identifier"]["id"] == name
+
+
+def test_bulk_diamond_dependency_order(cql2elm_node):
+    """A diamond (Top -> Left/Right -> Base) streams out dependencies first."""
+    libs = [
+        ("Top", _library("Top", includes=("Left", "Right"))),
+        ("Left", _library("Left", includes=("Base",))),
+        ("Right", _library("Right", includes=("Base",))),
+        ("Base", _library("Base")),
+    ]
+    result = cql2elm_node.execute(_bulk_sql(libs))
+    order = [row[0] for row in result]
+    assert sorted(order) == sorted(n for n, _ in libs)
+    assert order.index("Base") < order.index("Left")
+    assert order.index("Base") < order.index("Right")
+    assert order.index("Left") < order.index("Top")
+    assert order.index("Right") < order.index("Top")
+
+
+def test_bulk_repeated_include(cql2elm_node):
+    """Repeating the same include must not corrupt the dependency scan."""
+    body = "define One: 1"
+    cql = _library("Repeat", body=body, includes=("Base", "Base", "Base", "Base"))
+    libs = [("Repeat", cql), ("Base", _library("Base"))]
+    result = cql2elm_node.execute(_bulk_sql(libs))
+    order = [row[0] for row in result]
+    assert sorted(order) == ["Base", "Repeat"]
+    assert order.index("Base") < order.index("Repeat")
+
+
+def test_bulk_cycle_is_an_error(cql2elm_node):
+    """Mutually including libraries fail loudly instead of hanging."""
+    libs = [
+        ("CycleA", _library("CycleA", includes=("CycleB",))),
+        ("CycleB", _library("CycleB", includes=("CycleA",))),
+    ]
+    with pytest.raises(RuntimeError, match="(?i)cycl"):
+        cql2elm_node.execute(_bulk_sql(libs))
+
+
+def test_bulk_mismatched_lists(cql2elm_node):
+    """Unequal name/cql list lengths are rejected at bind time."""
+    with pytest.raises(RuntimeError, match="same length"):
+        cql2elm_node.execute(
+            "SELECT * FROM trex_fhir_cql_translate_bulk(['A', 'B'], ['library A'])"
+        )
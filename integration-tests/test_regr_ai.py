@@ -19,6 +19,7 @@ import json
 import math
 import os
 import subprocess
+import time
 import urllib.request
 
 import psycopg2
@@ -103,6 +104,20 @@ def _safe_unload(cur, name: str) -> None:
         pass
 
 
+def _wait_until_ready(cur, model_name: str, timeout: float = 120.0) -> None:
+    """Model loads are asynchronous; poll trex_ai_load_status until ready."""
+    deadline = time.time() + timeout
+    status = "unknown"
+    while time.time() < deadline:
+        cur.execute("SELECT trex_ai_load_status(%s)", (model_name,))
+        status = cur.fetchall()[0][0]
+        if status == "ready":
+            return
+        assert not status.startswith("failed"), status
+        time.sleep(0.5)
+    pytest.fail(f"model '{model_name}' not ready after {timeout}s (last status: {status})")
+
+
 def test_alias_respected(conn, tiny_model_in_container):
     """trex_ai_load_model('<path>', 'foo') should register under 'foo', not the file stem."""
     alias = "regr_alias_foo"
@@ -113,7 +128,8 @@ def test_alias_respected(conn, tiny_model_in_container):
             (tiny_model_in_container, alias),
         )
         load_resp = cur.fetchall()[0][0]
-        assert "success" in load_resp, load_resp
+        assert "loading" in load_resp, load_resp
+        _wait_until_ready(cur, alias)
 
         cur.execute("SELECT trex_ai_list_loaded()")
         listed = json.loads(cur.fetchall()[0][0])
@@ -157,7 +173,8 @@ def test_bert_embed_nonzero(conn, bert_model_in_container):
             (bert_model_in_container, alias),
         )
         load_resp = cur.fetchall()[0][0]
-        assert "success" in load_resp, load_resp
+        assert "loading" in load_resp, load_resp
+        _wait_until_ready(cur, alias)
 
         cur.execute("SELECT trex_ai_embed(%s, %s)", (alias, "hello"))
         embed_resp = cur.fetchall()[0][0]
@@ -0,0 +1,150 @@
+// Native micro-benchmarks for the extension hot paths, built as the
+// optional ai_bench target (-DBUILD_AI_BENCH=ON, needs google-benchmark).
+//
+// Model-backed benchmarks load the tiny GGUF fixture from
+// integration-tests/models; point AI_BENCH_MODEL at another file to
+// benchmark a different model. Run with --benchmark_format=json to get
+// output that CI can diff against a previous run.
+
+#include "ai_core.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace llama_capi {
+// Defined in ai_backend_bridge.cpp; exposed for this harness only.
+GenerationParams parse_generation_params(const char* options_json);
+}
+
+using llama_capi::GenerationParams;
+using llama_capi::ModelConfig;
+using llama_capi::SimpleModelManager;
+using llama_capi::StreamToken;
+
+static const char* kBenchModelName = "ai-bench-model";
+
+static std::string bench_model_path() {
+    const char* env = std::getenv("AI_BENCH_MODEL");
+    if (env && *env) {
+        return env;
+    }
+    // Relative to the repo root, where CI invokes the binary from.
+    return "integration-tests/models/tiny-test.gguf";
+}
+
+// Loads the fixture once for the whole run; returns false (and the caller
+// skips) when the file is missing so the parse-only benchmarks still run.
+static bool ensure_bench_model() {
+    static bool attempted = false;
+    static bool loaded = false;
+    if (attempted) {
+        return loaded;
+    }
+    attempted = true;
+
+    std::string path = bench_model_path();
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+
+    ModelConfig config;
+    config.model_path = path;
+    if (!SimpleModelManager::GetInstance().LoadModel(kBenchModelName, config)) {
+        return false;
+    }
+    // LoadModel is asynchronous; GetModel blocks until the load settles.
+    loaded = SimpleModelManager::GetInstance().GetModel(kBenchModelName) != nullptr;
+    return loaded;
+}
+
+static void BM_ParseGenerationParams(benchmark::State& state) {
+    const char* options =
+        "{\"max_tokens\": 64, \"temperature\": 0.7, \"top_p\": 0.9, \"top_k\": 40}";
+    for (auto _ : state) {
+        GenerationParams params = llama_capi::parse_generation_params(options);
+        benchmark::DoNotOptimize(params);
+    }
+}
+BENCHMARK(BM_ParseGenerationParams);
+
+static void BM_PoolAcquireRelease(benchmark::State& state) {
+    if (!ensure_bench_model()) {
+        state.SkipWithError("model fixture not found (set AI_BENCH_MODEL)");
+        return;
+    }
+    auto model = SimpleModelManager::GetInstance().GetModel(kBenchModelName);
+    for (auto _ : state) {
+        auto entry = model->context_pool->AcquireContext();
+        if (!entry) {
+            state.SkipWithError("failed to acquire context");
+            return;
+        }
+        model->context_pool->ReleaseContext(std::move(entry));
+    }
+}
+BENCHMARK(BM_PoolAcquireRelease);
+BENCHMARK(BM_PoolAcquireRelease)->Threads(4)->Name("BM_PoolAcquireRelease/mt");
+
+// Tokens/sec through the full Generate path (tokenize, prefill, decode
+// loop, sampler). items_per_second in the report is the token throughput.
+static void BM_GenerateTokens(benchmark::State& state) {
+    if (!ensure_bench_model()) {
+        state.SkipWithError("model fixture not found (set AI_BENCH_MODEL)");
+        return;
+    }
+    GenerationParams params;
+    params.max_tokens = (int)state.range(0);
+    // Sampled rather than greedy so the deterministic result cache does not
+    // short-circuit the decode loop being measured.
+    params.temperature = 0.7f;
+
+    int64_t tokens = 0;
+    for (auto _ : state) {
+        std::string result = SimpleModelManager::GetInstance().Generate(
+            kBenchModelName, "The quick brown fox", params);
+        benchmark::DoNotOptimize(result);
+        tokens += params.max_tokens;
+    }
+    state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_GenerateTokens)->Arg(16)->UseRealTime();
+BENCHMARK(BM_GenerateTokens)->Arg(16)->Threads(4)->UseRealTime()->Name("BM_GenerateTokens/mt");
+
+// Cost of moving one token from the decode slice through the ring to the
+// consumer, excluding model startup: the session streams max_tokens tokens
+// and the loop drains them as they arrive.
+static void BM_StreamingHandoff(benchmark::State& state) {
+    if (!ensure_bench_model()) {
+        state.SkipWithError("model fixture not found (set AI_BENCH_MODEL)");
+        return;
+    }
+    GenerationParams params;
+    params.max_tokens = 32;
+    params.temperature = 0.7f;
+
+    int64_t tokens = 0;
+    for (auto _ : state) {
+        std::string session_id = SimpleModelManager::GetInstance().StartStreamingSession(
+            kBenchModelName, "The quick brown fox", params);
+        if (session_id.rfind("Error:", 0) == 0) {
+            state.SkipWithError("failed to start streaming session");
+            return;
+        }
+        StreamToken token;
+        while (SimpleModelManager::GetInstance().GetNextStreamToken(session_id, token)) {
+            benchmark::DoNotOptimize(token);
+            tokens++;
+            if (token.is_final) {
+                break;
+            }
+        }
+        SimpleModelManager::GetInstance().StopStreamingSession(session_id);
+    }
+    state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_StreamingHandoff)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,6 +1,7 @@
 #include "include/ai_functions.h"
 #include "include/ai_core.hpp"
 #include "include/http_downloader.hpp"
+#include "include/trace_ring.h"
 
 
 #include "llama.h"
@@ -12,10 +13,13 @@
 #include <string>
 #include <memory>
 #include <cstring>
+#include <cstdio>
 
-namespace {
+// External linkage so the ai_bench harness can measure parsing overhead in
+// isolation; everything else treats this as file-local.
+namespace llama_capi {
 
-llama_capi::GenerationParams parse_generation_params(const char* options_json) {
+GenerationParams parse_generation_params(const char* options_json) {
     llama_capi::GenerationParams params;
     
     if (!options_json || strlen(options_json) == 0) {
@@ -69,6 +73,11 @@ llama_capi::GenerationParams parse_generation_params(const char* options_json) {
 #include <filesystem>
 #include <fstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 static char* string_to_cstring(const std::string& str) {
     char* result = static_cast<char*>(std::malloc(str.length() + 1));
@@ -147,6 +156,36 @@ static llama_capi::ModelConfig parse_model_config(const std::string& config_json
         }
     }
 
+    // Speculative decoding: "draft_model_path" pairs a small draft model with
+    // this load, "draft_tokens" bounds how far the draft runs ahead.
+    yyjson_val *draft_path_val = yyjson_obj_get(root, "draft_model_path");
+    if (draft_path_val && yyjson_is_str(draft_path_val)) {
+        config.draft_model_path = yyjson_get_str(draft_path_val);
+    }
+
+    yyjson_val *draft_tokens_val = yyjson_obj_get(root, "draft_tokens");
+    if (draft_tokens_val && yyjson_is_int(draft_tokens_val)) {
+        config.draft_n_tokens = static_cast<int>(yyjson_get_int(draft_tokens_val));
+    }
+
+    // Device placement: "main_gpu" picks the host device, "tensor_split" is
+    // an array of per-device layer proportions, e.g. [0, 1, 1, 1].
+    yyjson_val *main_gpu_val = yyjson_obj_get(root, "main_gpu");
+    if (main_gpu_val && yyjson_is_int(main_gpu_val)) {
+        config.main_gpu = static_cast<int>(yyjson_get_int(main_gpu_val));
+    }
+
+    yyjson_val *tensor_split_val = yyjson_obj_get(root, "tensor_split");
+    if (tensor_split_val && yyjson_is_arr(tensor_split_val)) {
+        size_t idx, max;
+        yyjson_val *elem;
+        yyjson_arr_foreach(tensor_split_val, idx, max, elem) {
+            if (yyjson_is_num(elem)) {
+                config.tensor_split.push_back(static_cast<float>(yyjson_get_num(elem)));
+            }
+        }
+    }
+
     yyjson_doc_free(doc);
     return config;
 }
@@ -155,6 +194,187 @@ static llama_capi::SimpleModelManager& get_manager() {
     return llama_capi::SimpleModelManager::GetInstance();
 }
 
+// Metadata mirror of the definition in ai_functions.c; filled by
+// cpp_llama_gguf_info from a GGUF file's header and KV section without
+// loading the model.
+struct cpp_llama_gguf_info_t {
+    char* architecture;      // malloc'd, NULL when absent
+    char* quantization;      // malloc'd, NULL when absent
+    uint64_t parameter_count;
+    uint64_t context_length;   // 0 when absent
+    uint64_t embedding_length; // 0 when absent
+    uint32_t gguf_version;
+    uint64_t tensor_count;
+    char* error;             // malloc'd; non-NULL means the other fields are invalid
+};
+
+namespace {
+
+// Bounds-checked little-endian cursor over the mapped file. Every read
+// checks remaining bytes; the first short read poisons the cursor, so the
+// parser cannot walk past a truncated or corrupt file.
+struct GgufCursor {
+    const uint8_t* p;
+    size_t remaining;
+    bool ok = true;
+
+    bool Take(void* out, size_t n) {
+        if (!ok || n > remaining) {
+            ok = false;
+            return false;
+        }
+        std::memcpy(out, p, n);
+        p += n;
+        remaining -= n;
+        return true;
+    }
+
+    uint32_t U32() { uint32_t v = 0; Take(&v, sizeof(v)); return v; }
+    uint64_t U64() { uint64_t v = 0; Take(&v, sizeof(v)); return v; }
+
+    // GGUF string: u64 length + bytes (not NUL-terminated in the file).
+    std::string Str() {
+        uint64_t len = U64();
+        if (!ok || len > remaining) {
+            ok = false;
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char*>(p), len);
+        p += len;
+        remaining -= len;
+        return s;
+    }
+
+    bool Skip(size_t n) {
+        if (!ok || n > remaining) {
+            ok = false;
+            return false;
+        }
+        p += n;
+        remaining -= n;
+        return true;
+    }
+};
+
+// GGUF metadata value types.
+enum GgufType : uint32_t {
+    GGUF_TYPE_UINT8 = 0, GGUF_TYPE_INT8 = 1, GGUF_TYPE_UINT16 = 2, GGUF_TYPE_INT16 = 3,
+    GGUF_TYPE_UINT32 = 4, GGUF_TYPE_INT32 = 5, GGUF_TYPE_FLOAT32 = 6, GGUF_TYPE_BOOL = 7,
+    GGUF_TYPE_STRING = 8, GGUF_TYPE_ARRAY = 9,
+    GGUF_TYPE_UINT64 = 10, GGUF_TYPE_INT64 = 11, GGUF_TYPE_FLOAT64 = 12
+};
+
+static size_t GgufScalarSize(uint32_t type) {
+    switch (type) {
+        case GGUF_TYPE_UINT8: case GGUF_TYPE_INT8: case GGUF_TYPE_BOOL: return 1;
+        case GGUF_TYPE_UINT16: case GGUF_TYPE_INT16: return 2;
+        case GGUF_TYPE_UINT32: case GGUF_TYPE_INT32: case GGUF_TYPE_FLOAT32: return 4;
+        case GGUF_TYPE_UINT64: case GGUF_TYPE_INT64: case GGUF_TYPE_FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+// Skips one value of the given type; arrays recurse one level (GGUF does
+// not nest arrays inside arrays).
+static void GgufSkipValue(GgufCursor& cur, uint32_t type) {
+    if (type == GGUF_TYPE_STRING) {
+        cur.Str();
+        return;
+    }
+    if (type == GGUF_TYPE_ARRAY) {
+        uint32_t elem_type = cur.U32();
+        uint64_t count = cur.U64();
+        if (elem_type == GGUF_TYPE_STRING) {
+            for (uint64_t i = 0; cur.ok && i < count; i++) {
+                cur.Str();
+            }
+        } else {
+            size_t elem_size = GgufScalarSize(elem_type);
+            if (elem_size == 0 || count > cur.remaining / elem_size) {
+                cur.ok = false;
+                return;
+            }
+            cur.Skip((size_t)count * elem_size);
+        }
+        return;
+    }
+    size_t size = GgufScalarSize(type);
+    if (size == 0) {
+        cur.ok = false;
+        return;
+    }
+    cur.Skip(size);
+}
+
+// Reads any integer-typed value into a uint64; other types are skipped and
+// reported as absent.
+static bool GgufReadUint(GgufCursor& cur, uint32_t type, uint64_t* out) {
+    switch (type) {
+        case GGUF_TYPE_UINT8: case GGUF_TYPE_INT8: case GGUF_TYPE_BOOL: {
+            uint8_t v = 0; cur.Take(&v, 1); *out = v; return cur.ok;
+        }
+        case GGUF_TYPE_UINT16: case GGUF_TYPE_INT16: {
+            uint16_t v = 0; cur.Take(&v, 2); *out = v; return cur.ok;
+        }
+        case GGUF_TYPE_UINT32: case GGUF_TYPE_INT32: {
+            uint32_t v = 0; cur.Take(&v, 4); *out = v; return cur.ok;
+        }
+        case GGUF_TYPE_UINT64: case GGUF_TYPE_INT64: {
+            uint64_t v = 0; cur.Take(&v, 8); *out = v; return cur.ok;
+        }
+        default:
+            GgufSkipValue(cur, type);
+            return false;
+    }
+}
+
+// general.file_type values (the llama_ftype enum). Unknown values render
+// as the raw number so new quantizations still show something useful.
+static std::string GgufFileTypeName(uint64_t ftype) {
+    // 1024 flags a value guessed from the tensor types rather than stored.
+    bool guessed = (ftype & 1024) != 0;
+    switch (ftype & ~(uint64_t)1024) {
+        case 0: return guessed ? "F32 (guessed)" : "F32";
+        case 1: return guessed ? "F16 (guessed)" : "F16";
+        case 2: return "Q4_0";
+        case 3: return "Q4_1";
+        case 7: return "Q8_0";
+        case 8: return "Q5_0";
+        case 9: return "Q5_1";
+        case 10: return "Q2_K";
+        case 11: return "Q3_K_S";
+        case 12: return "Q3_K_M";
+        case 13: return "Q3_K_L";
+        case 14: return "Q4_K_S";
+        case 15: return "Q4_K_M";
+        case 16: return "Q5_K_S";
+        case 17: return "Q5_K_M";
+        case 18: return "Q6_K";
+        case 19: return "IQ2_XXS";
+        case 20: return "IQ2_XS";
+        case 21: return "Q2_K_S";
+        case 22: return "IQ3_XS";
+        case 23: return "IQ3_XXS";
+        case 24: return "IQ1_S";
+        case 25: return "IQ4_NL";
+        case 26: return "IQ3_S";
+        case 27: return "IQ3_M";
+        case 28: return "IQ2_S";
+        case 29: return "IQ2_M";
+        case 30: return "IQ4_XS";
+        case 31: return "IQ1_M";
+        case 32: return "BF16";
+        default: return "unknown(" + std::to_string(ftype) + ")";
+    }
+}
+
+static bool GgufHasSuffix(const std::string& key, const char* suffix) {
+    size_t len = std::strlen(suffix);
+    return key.size() >= len && key.compare(key.size() - len, len, suffix) == 0;
+}
+
+} // namespace
+
 extern "C" {
 
 char* cpp_llama_load_model(const char* path, const char* alias_or_config) {
@@ -183,7 +403,10 @@ char* cpp_llama_load_model(const char* path, const char* alias_or_config) {
             : alias;
 
         if (get_manager().LoadModel(model_name, config)) {
-            std::string result = "{\"status\": \"success\", \"model_name\": \"" + model_name + "\", \"path\": \"" + path_str + "\"}";
+            // Loading continues on a background thread; poll
+            // cpp_llama_model_load_status for readiness. Generate/embed calls
+            // issued meanwhile block until the load finishes.
+            std::string result = "{\"status\": \"loading\", \"model_name\": \"" + model_name + "\", \"path\": \"" + path_str + "\"}";
             return string_to_cstring(result);
         } else {
             return string_to_cstring("Error: Failed to load model");
@@ -193,6 +416,17 @@ char* cpp_llama_load_model(const char* path, const char* alias_or_config) {
     }
 }
 
+char* cpp_llama_model_load_status(const char* model_name) {
+    try {
+        if (!model_name) {
+            return string_to_cstring("Error: Model name is required");
+        }
+        return string_to_cstring(get_manager().GetModelLoadStatus(cstring_to_string(model_name)));
+    } catch (const std::exception& e) {
+        return string_to_cstring(std::string("Error: ") + e.what());
+    }
+}
+
 char* cpp_llama_unload_model(const char* model_name) {
     try {
         if (!model_name) {
@@ -222,9 +456,11 @@ char* cpp_llama_generate(const char* model, const char* prompt, const char* opti
         std::string prompt_str = cstring_to_string(prompt);
         std::string options_str = cstring_to_string(options_json);
 
-        llama_capi::GenerationParams params = parse_generation_params(options_str.c_str());
-        
+        llama_capi::GenerationParams params = llama_capi::parse_generation_params(options_str.c_str());
+
+        uint64_t trace_start = trace_ring_now_ns();
         std::string response = get_manager().Generate(model_str, prompt_str, params);
+        trace_ring_record("generate", trace_start);
         return string_to_cstring(response);
         
     } catch (const std::exception& e) {
@@ -232,6 +468,74 @@ char* cpp_llama_generate(const char* model, const char* prompt, const char* opti
     }
 }
 
+// Generates a whole data chunk's worth of rows against one model, fanning
+// rows out across a worker pool sized to the model's context pool. Workers
+// claim rows from a shared atomic cursor, so one finishing a short
+// generation immediately takes the next row instead of idling behind a long
+// one. Returns a malloc'd array of malloc'd result strings, one per input
+// row; the caller frees both. Returns NULL if the batch could not be run.
+char** cpp_llama_generate_batch(const char* model, const char* const* prompts, size_t count, const char* options_json) {
+    try {
+        if (!model || !prompts || count == 0) {
+            return nullptr;
+        }
+
+        std::string model_str = cstring_to_string(model);
+        std::string options_str = cstring_to_string(options_json);
+        llama_capi::GenerationParams params = llama_capi::parse_generation_params(options_str.c_str());
+
+        std::vector<std::string> prompt_strs;
+        prompt_strs.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            prompt_strs.emplace_back(cstring_to_string(prompts[i]));
+        }
+
+        size_t workers = 1;
+        auto loaded = get_manager().GetModel(model_str);
+        if (loaded && loaded->context_pool) {
+            workers = std::min(count, loaded->context_pool->GetMaxPoolSize());
+        }
+
+        std::vector<std::string> responses(count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t trace_start = trace_ring_now_ns();
+                responses[i] = get_manager().Generate(model_str, prompt_strs[i], params);
+                trace_ring_record("generate_batch_row", trace_start);
+            }
+        } else {
+            std::atomic<size_t> next_row{0};
+            std::vector<std::thread> threads;
+            threads.reserve(workers);
+            for (size_t w = 0; w < workers; ++w) {
+                threads.emplace_back([&]() {
+                    size_t i;
+                    while ((i = next_row.fetch_add(1)) < count) {
+                        uint64_t trace_start = trace_ring_now_ns();
+                        responses[i] = get_manager().Generate(model_str, prompt_strs[i], params);
+                        trace_ring_record("generate_batch_row", trace_start);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        char** results = static_cast<char**>(std::malloc(count * sizeof(char*)));
+        if (!results) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            results[i] = string_to_cstring(responses[i]);
+        }
+        return results;
+
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
 char* cpp_llama_embed(const char* model, const char* text) {
     try {
         if (!model || !text) {
@@ -241,8 +545,10 @@ char* cpp_llama_embed(const char* model, const char* text) {
         std::string model_str = cstring_to_string(model);
         std::string text_str = cstring_to_string(text);
 
+        uint64_t trace_start = trace_ring_now_ns();
         auto embeddings = get_manager().GetEmbeddings(model_str, text_str);
-        
+        trace_ring_record("embed", trace_start);
+
         std::ostringstream oss;
         oss << "{\"embeddings\": [";
         for (size_t i = 0; i < embeddings.size(); ++i) {
@@ -258,6 +564,128 @@ char* cpp_llama_embed(const char* model, const char* text) {
     }
 }
 
+// Raw-float embed variants backing the LIST(FLOAT) SQL path: no JSON text
+// round-trip, the caller memcpys the buffer straight into a DuckDB child
+// vector. Returns a malloc'd float buffer (caller frees) and writes the
+// embedding width to out_dim, or NULL on failure.
+float* cpp_llama_embed_raw(const char* model, const char* text, size_t* out_dim) {
+    try {
+        if (out_dim) *out_dim = 0;
+        if (!model || !text || !out_dim) {
+            return nullptr;
+        }
+
+        uint64_t trace_start = trace_ring_now_ns();
+        auto embeddings = get_manager().GetEmbeddings(cstring_to_string(model), cstring_to_string(text));
+        trace_ring_record("embed_raw", trace_start);
+        if (embeddings.empty()) {
+            return nullptr;
+        }
+
+        float* buffer = static_cast<float*>(std::malloc(embeddings.size() * sizeof(float)));
+        if (!buffer) {
+            return nullptr;
+        }
+        std::memcpy(buffer, embeddings.data(), embeddings.size() * sizeof(float));
+        *out_dim = embeddings.size();
+        return buffer;
+
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+// Batched raw-float embed: one multi-sequence decode for the whole chunk.
+// Returns a malloc'd array of per-row malloc'd float buffers (entries may be
+// NULL on per-row failure) and writes the shared embedding width to out_dim.
+float** cpp_llama_embed_raw_batch(const char* model, const char* const* texts, size_t count, size_t* out_dim) {
+    try {
+        if (out_dim) *out_dim = 0;
+        if (!model || !texts || count == 0 || !out_dim) {
+            return nullptr;
+        }
+
+        std::vector<std::string> text_strs;
+        text_strs.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            text_strs.emplace_back(cstring_to_string(texts[i]));
+        }
+
+        uint64_t trace_start = trace_ring_now_ns();
+        auto embeddings = get_manager().GetEmbeddingsBatch(cstring_to_string(model), text_strs);
+        trace_ring_record("embed_raw_batch", trace_start);
+
+        float** results = static_cast<float**>(std::malloc(count * sizeof(float*)));
+        if (!results) {
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (i >= embeddings.size() || embeddings[i].empty()) {
+                results[i] = nullptr;
+                continue;
+            }
+            results[i] = static_cast<float*>(std::malloc(embeddings[i].size() * sizeof(float)));
+            if (results[i]) {
+                std::memcpy(results[i], embeddings[i].data(), embeddings[i].size() * sizeof(float));
+                *out_dim = embeddings[i].size();
+            }
+        }
+
+        return results;
+
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+// Embeds a whole data chunk's worth of rows against one model in a single
+// multi-sequence decode. Returns a malloc'd array of malloc'd JSON strings,
+// one per input row (entries may be NULL on per-row failure); the caller
+// frees both. Returns NULL if the batch could not be run at all.
+char** cpp_llama_embed_batch(const char* model, const char* const* texts, size_t count) {
+    try {
+        if (!model || !texts || count == 0) {
+            return nullptr;
+        }
+
+        std::vector<std::string> text_strs;
+        text_strs.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            text_strs.emplace_back(cstring_to_string(texts[i]));
+        }
+
+        uint64_t trace_start = trace_ring_now_ns();
+        auto embeddings = get_manager().GetEmbeddingsBatch(cstring_to_string(model), text_strs);
+        trace_ring_record("embed_batch", trace_start);
+
+        char** results = static_cast<char**>(std::malloc(count * sizeof(char*)));
+        if (!results) {
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (i >= embeddings.size() || embeddings[i].empty()) {
+                results[i] = nullptr;
+                continue;
+            }
+            std::ostringstream oss;
+            oss << "{\"embeddings\": [";
+            for (size_t j = 0; j < embeddings[i].size(); ++j) {
+                if (j > 0) oss << ", ";
+                oss << embeddings[i][j];
+            }
+            oss << "]}";
+            results[i] = string_to_cstring(oss.str());
+        }
+
+        return results;
+
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
 char* cpp_llama_batch_process(const char* json_request) {
     try {
         if (!json_request) {
@@ -352,7 +780,7 @@ char* cpp_llama_start_streaming(const char* model, const char* prompt, const cha
         std::string model_str = cstring_to_string(model);
         std::string prompt_str = cstring_to_string(prompt);
 
-        llama_capi::GenerationParams params = parse_generation_params(options_json);
+        llama_capi::GenerationParams params = llama_capi::parse_generation_params(options_json);
         std::string session_id = get_manager().StartStreamingSession(model_str, prompt_str, params);
 
         yyjson_mut_doc *response_doc = yyjson_mut_doc_new(nullptr);
@@ -384,6 +812,39 @@ char* cpp_llama_start_streaming(const char* model, const char* prompt, const cha
     }
 }
 
+// Non-blocking companion to cpp_llama_get_stream_token: returns NULL when no
+// token is queued yet, letting the table function fill a partial chunk with
+// whatever is already available instead of blocking per row.
+char* cpp_llama_try_get_stream_token(const char* session_id) {
+    try {
+        if (!session_id) {
+            return nullptr;
+        }
+
+        llama_capi::StreamToken token;
+        if (!get_manager().TryGetNextStreamToken(cstring_to_string(session_id), token)) {
+            return nullptr;
+        }
+
+        yyjson_mut_doc *response_doc = yyjson_mut_doc_new(nullptr);
+        yyjson_mut_val *response_root = yyjson_mut_obj(response_doc);
+        yyjson_mut_doc_set_root(response_doc, response_root);
+
+        yyjson_mut_obj_add_str(response_doc, response_root, "token", token.text.c_str());
+        yyjson_mut_obj_add_bool(response_doc, response_root, "is_final", token.is_final);
+        yyjson_mut_obj_add_real(response_doc, response_root, "probability", token.probability);
+
+        char *response_json = yyjson_mut_write(response_doc, 0, nullptr);
+        std::string result(response_json);
+        free(response_json);
+        yyjson_mut_doc_free(response_doc);
+
+        return string_to_cstring(result);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
 char* cpp_llama_get_stream_token(const char* session_id) {
     try {
         if (!session_id) {
@@ -466,6 +927,40 @@ char* cpp_llama_get_batch_result(const char* request_id) {
     }
 }
 
+// Cursor-based polling: returns every result completed after `cursor` and
+// the cursor to pass next time. Returned results leave the store, so
+// repeated polls never re-transfer the same response text.
+char* cpp_llama_batch_results_since(uint64_t cursor) {
+    try {
+        uint64_t next_cursor = cursor;
+        auto results = get_manager().GetBatchResultsSince(cursor, next_cursor);
+
+        yyjson_mut_doc *doc = yyjson_mut_doc_new(nullptr);
+        yyjson_mut_val *root = yyjson_mut_obj(doc);
+        yyjson_mut_doc_set_root(doc, root);
+
+        yyjson_mut_obj_add_uint(doc, root, "next_cursor", next_cursor);
+        yyjson_mut_val *arr = yyjson_mut_obj_add_arr(doc, root, "results");
+        for (const auto& result : results) {
+            yyjson_mut_val *obj = yyjson_mut_arr_add_obj(doc, arr);
+            yyjson_mut_obj_add_str(doc, obj, "request_id", result.request_id.c_str());
+            yyjson_mut_obj_add_bool(doc, obj, "success", result.success);
+            yyjson_mut_obj_add_str(doc, obj, "response", result.response.c_str());
+            yyjson_mut_obj_add_str(doc, obj, "error_message", result.error_message.c_str());
+            yyjson_mut_obj_add_uint(doc, obj, "processing_time_ms", result.processing_time_ms);
+        }
+
+        char *json = yyjson_mut_write(doc, 0, nullptr);
+        std::string out(json ? json : "{}");
+        if (json) free(json);
+        yyjson_mut_doc_free(doc);
+
+        return string_to_cstring(out);
+    } catch (const std::exception& e) {
+        return string_to_cstring(std::string("Error: ") + e.what());
+    }
+}
+
 char* cpp_llama_status() {
     try {
         std::string result = "{\"backend\": \"llama.cpp\", \"models_loaded\": " + 
@@ -495,23 +990,150 @@ char* cpp_llama_model_info(const char* name) {
     }
 }
 
+// Metadata-only GGUF reader: maps the file and parses just the header, KV
+// section, and tensor descriptors - the tensor data itself is never touched,
+// so only the few metadata pages are ever faulted in regardless of model
+// size. Parameter count is the summed element count of all tensors; context
+// and embedding widths come from the architecture-prefixed KV keys. Returns
+// 0 with out->error set on failure; the caller frees via
+// cpp_llama_free_gguf_info either way.
+int cpp_llama_gguf_info(const char* path, struct cpp_llama_gguf_info_t* out) {
+    std::memset(out, 0, sizeof(*out));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        out->error = string_to_cstring(std::string("cannot open ") + path);
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 24) {
+        close(fd);
+        out->error = string_to_cstring(std::string("not a GGUF file: ") + path);
+        return 0;
+    }
+    void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        out->error = string_to_cstring(std::string("mmap failed for ") + path);
+        return 0;
+    }
+
+    GgufCursor cur;
+    cur.p = (const uint8_t*)mapped;
+    cur.remaining = (size_t)st.st_size;
+
+    uint32_t magic = cur.U32();
+    uint32_t version = cur.U32();
+    if (!cur.ok || magic != 0x46554747 /* "GGUF" */ || version < 2 || version > 3) {
+        munmap(mapped, (size_t)st.st_size);
+        out->error = string_to_cstring(std::string("not a GGUF v2/v3 file: ") + path);
+        return 0;
+    }
+    uint64_t tensor_count = cur.U64();
+    uint64_t kv_count = cur.U64();
+
+    std::string architecture;
+    uint64_t file_type = 0;
+    bool have_file_type = false;
+
+    for (uint64_t i = 0; cur.ok && i < kv_count; i++) {
+        std::string key = cur.Str();
+        uint32_t type = cur.U32();
+        if (!cur.ok) break;
+        if (key == "general.architecture" && type == GGUF_TYPE_STRING) {
+            architecture = cur.Str();
+        } else if (key == "general.file_type") {
+            have_file_type = GgufReadUint(cur, type, &file_type);
+        } else if (GgufHasSuffix(key, ".context_length")) {
+            GgufReadUint(cur, type, &out->context_length);
+        } else if (GgufHasSuffix(key, ".embedding_length")) {
+            GgufReadUint(cur, type, &out->embedding_length);
+        } else {
+            GgufSkipValue(cur, type);
+        }
+    }
+
+    // Tensor descriptors follow the KV section: name, dims, type, offset.
+    uint64_t parameter_count = 0;
+    for (uint64_t i = 0; cur.ok && i < tensor_count; i++) {
+        cur.Str(); // tensor name
+        uint32_t n_dims = cur.U32();
+        if (!cur.ok || n_dims > 8) {
+            cur.ok = false;
+            break;
+        }
+        uint64_t elements = 1;
+        for (uint32_t d = 0; d < n_dims; d++) {
+            elements *= cur.U64();
+        }
+        cur.U32(); // tensor data type
+        cur.U64(); // data offset
+        if (cur.ok) {
+            parameter_count += elements;
+        }
+    }
+
+    munmap(mapped, (size_t)st.st_size);
+
+    if (!cur.ok) {
+        out->error = string_to_cstring(std::string("truncated or corrupt GGUF metadata: ") + path);
+        return 0;
+    }
+
+    out->gguf_version = version;
+    out->tensor_count = tensor_count;
+    out->parameter_count = parameter_count;
+    if (!architecture.empty()) {
+        out->architecture = string_to_cstring(architecture);
+    }
+    if (have_file_type) {
+        out->quantization = string_to_cstring(GgufFileTypeName(file_type));
+    }
+    return 1;
+}
+
+void cpp_llama_free_gguf_info(struct cpp_llama_gguf_info_t* info) {
+    if (!info) return;
+    std::free(info->architecture);
+    std::free(info->quantization);
+    std::free(info->error);
+}
+
 char* cpp_llama_gpu_info() {
     try {
-        std::ostringstream oss;
-        oss << "{\\n";
-        oss << "  \"gpu_available\": " << (llama_supports_gpu_offload() ? "true" : "false") << ",\\n";
-        oss << "  \"backend\": \"vulkan\",\\n";
-        oss << "  \"devices\": [\\n";
-        oss << "    {\\n";
-        oss << "      \"id\": 0,\\n";
-        oss << "      \"name\": \"Default GPU\",\\n";
-        oss << "      \"memory_total\": 0,\\n";
-        oss << "      \"memory_used\": 0\\n";
-        oss << "    }\\n";
-        oss << "  ]\\n";
-        oss << "}";
-        
-        return string_to_cstring(oss.str());
+        auto devices = get_manager().GetGPUInfo();
+
+        size_t gpu_count = 0;
+        for (const auto& dev : devices) {
+            if (dev.is_gpu) ++gpu_count;
+        }
+
+        yyjson_mut_doc *doc = yyjson_mut_doc_new(nullptr);
+        yyjson_mut_val *root = yyjson_mut_obj(doc);
+        yyjson_mut_doc_set_root(doc, root);
+
+        yyjson_mut_obj_add_bool(doc, root, "gpu_available", llama_supports_gpu_offload() && gpu_count > 0);
+        yyjson_mut_obj_add_uint(doc, root, "gpu_count", gpu_count);
+
+        yyjson_mut_val *arr = yyjson_mut_arr(doc);
+        yyjson_mut_obj_add_val(doc, root, "devices", arr);
+        for (const auto& dev : devices) {
+            yyjson_mut_val *obj = yyjson_mut_obj(doc);
+            yyjson_mut_obj_add_int(doc, obj, "id", dev.index);
+            yyjson_mut_obj_add_strcpy(doc, obj, "name", dev.name.c_str());
+            yyjson_mut_obj_add_strcpy(doc, obj, "description", dev.description.c_str());
+            yyjson_mut_obj_add_str(doc, obj, "type", dev.is_gpu ? "gpu" : "cpu");
+            yyjson_mut_obj_add_uint(doc, obj, "memory_free", dev.memory_free);
+            yyjson_mut_obj_add_uint(doc, obj, "memory_total", dev.memory_total);
+            yyjson_mut_arr_append(arr, obj);
+        }
+
+        char *json = yyjson_mut_write(doc, YYJSON_WRITE_PRETTY, nullptr);
+        std::string result = json ? json : "{}";
+        if (json) free(json);
+        yyjson_mut_doc_free(doc);
+
+        return string_to_cstring(result);
     } catch (const std::exception& e) {
         return string_to_cstring(std::string("Error: ") + e.what());
     }
@@ -620,22 +1242,29 @@ char* cpp_llama_download_model(const char* source, const char* name, const char*
                 return string_to_cstring("Error: Downloaded file too small, check URL: " + source_str);
             }
 
+            // Hash computed during the downloader's page-warming pass;
+            // callers compare it against a published digest.
+            char hash_hex[17] = {0};
+            snprintf(hash_hex, sizeof(hash_hex), "%016llx",
+                     (unsigned long long)download_result.content_hash);
+            std::string hash_field = ", \"content_hash\": \"" + std::string(hash_hex) + "\"";
+
             std::ifstream file(output_path, std::ios::binary);
             if (file) {
                 char magic[4];
                 file.read(magic, 4);
                 if (file.gcount() == 4 && std::strncmp(magic, "GGUF", 4) == 0) {
                     std::string response = "{\"status\": \"success\", \"filename\": \"" + filename +
-                                         "\", \"size\": " + std::to_string(file_size) + ", \"validated\": true}";
+                                         "\", \"size\": " + std::to_string(file_size) + hash_field + ", \"validated\": true}";
                     return string_to_cstring(response);
                 } else {
                     std::string response = "{\"status\": \"success\", \"filename\": \"" + filename +
-                                         "\", \"size\": " + std::to_string(file_size) + ", \"validated\": false, \"warning\": \"Not a valid GGUF file\"}";
+                                         "\", \"size\": " + std::to_string(file_size) + hash_field + ", \"validated\": false, \"warning\": \"Not a valid GGUF file\"}";
                     return string_to_cstring(response);
                 }
             } else {
                 std::string response = "{\"status\": \"success\", \"filename\": \"" + filename +
-                                     "\", \"size\": " + std::to_string(file_size) + ", \"validated\": false}";
+                                     "\", \"size\": " + std::to_string(file_size) + hash_field + ", \"validated\": false}";
                 return string_to_cstring(response);
             }
         } else {
@@ -680,7 +1309,7 @@ char* cpp_llama_load_model_for_embeddings(const char* path, const char* alias_or
             : alias;
 
         if (get_manager().LoadModel(model_name, config)) {
-            std::string result = "{\"status\": \"success\", \"model_name\": \"" + model_name + "\", \"path\": \"" + path_str + "\", \"embeddings_enabled\": true}";
+            std::string result = "{\"status\": \"loading\", \"model_name\": \"" + model_name + "\", \"path\": \"" + path_str + "\", \"embeddings_enabled\": true}";
             return string_to_cstring(result);
         } else {
             return string_to_cstring("Error: Failed to load model for embeddings");
@@ -743,7 +1372,7 @@ char* cpp_llama_chat(const char* model, const char* messages_json, const char* o
             return string_to_cstring("{\"error\": \"No valid messages found\"}");
         }
 
-        llama_capi::GenerationParams params = parse_generation_params(options_json);
+        llama_capi::GenerationParams params = llama_capi::parse_generation_params(options_json);
         std::string response = get_manager().ChatCompletion(model_str, messages, params);
 
         yyjson_mut_doc *response_doc = yyjson_mut_doc_new(nullptr);
@@ -814,6 +1443,63 @@ char* cpp_llama_get_performance_metrics() {
     }
 }
 
+// Mirror of the declaration in ai_functions.c; one row per (model, phase)
+// pair with percentile fields, consumed by the latency table function.
+struct cpp_llama_latency_row {
+    char* model;
+    char* metric;
+    uint64_t count;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+cpp_llama_latency_row* cpp_llama_latency_rows(size_t* out_count) {
+    if (!out_count) {
+        return nullptr;
+    }
+    *out_count = 0;
+    try {
+        auto rows = get_manager().GetLatencySnapshot();
+        if (rows.empty()) {
+            return nullptr;
+        }
+
+        cpp_llama_latency_row* result =
+            (cpp_llama_latency_row*)malloc(rows.size() * sizeof(cpp_llama_latency_row));
+        if (!result) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < rows.size(); ++i) {
+            result[i].model = string_to_cstring(rows[i].model);
+            result[i].metric = string_to_cstring(rows[i].metric);
+            result[i].count = rows[i].count;
+            result[i].mean_ms = rows[i].mean_ms;
+            result[i].p50_ms = rows[i].p50_ms;
+            result[i].p95_ms = rows[i].p95_ms;
+            result[i].p99_ms = rows[i].p99_ms;
+            result[i].max_ms = rows[i].max_ms;
+        }
+        *out_count = rows.size();
+        return result;
+    } catch (const std::exception& e) {
+        return nullptr;
+    }
+}
+
+void cpp_llama_free_latency_rows(cpp_llama_latency_row* rows, size_t count) {
+    if (!rows) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        free(rows[i].model);
+        free(rows[i].metric);
+    }
+    free(rows);
+}
+
 char* cpp_llama_get_memory_status() {
     try {
         auto& mgr = get_manager();
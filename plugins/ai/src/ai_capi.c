@@ -61,6 +61,16 @@ DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info
         duckdb_destroy_scalar_function(&function);
     }
 
+    {
+        duckdb_scalar_function function = duckdb_create_scalar_function();
+        duckdb_scalar_function_set_name(function, "trex_ai_load_status");
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_set_return_type(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_set_function(function, llama_load_status_function);
+        duckdb_register_scalar_function(connection, function);
+        duckdb_destroy_scalar_function(&function);
+    }
+
     {
         duckdb_scalar_function function = duckdb_create_scalar_function();
         duckdb_scalar_function_set_name(function, "trex_ai_unload_model");
@@ -115,6 +125,57 @@ DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info
         duckdb_destroy_scalar_function(&function);
     }
 
+    {
+        duckdb_scalar_function function = duckdb_create_scalar_function();
+        duckdb_scalar_function_set_name(function, "trex_ai_embed_list");
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_logical_type float_type = duckdb_create_logical_type(DUCKDB_TYPE_FLOAT);
+        duckdb_logical_type list_type = duckdb_create_list_type(float_type);
+        duckdb_scalar_function_set_return_type(function, list_type);
+        duckdb_destroy_logical_type(&list_type);
+        duckdb_destroy_logical_type(&float_type);
+        duckdb_scalar_function_set_function(function, llama_embed_list_function);
+        duckdb_register_scalar_function(connection, function);
+        duckdb_destroy_scalar_function(&function);
+    }
+
+    {
+        // Int8-quantized embeddings: STRUCT(scale FLOAT, values TINYINT[]),
+        // x ~= values[i] * scale. 4x smaller than the fp32 list.
+        duckdb_scalar_function function = duckdb_create_scalar_function();
+        duckdb_scalar_function_set_name(function, "trex_ai_embed_i8");
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_logical_type scale_type = duckdb_create_logical_type(DUCKDB_TYPE_FLOAT);
+        duckdb_logical_type tinyint_type = duckdb_create_logical_type(DUCKDB_TYPE_TINYINT);
+        duckdb_logical_type values_type = duckdb_create_list_type(tinyint_type);
+        duckdb_logical_type member_types[2] = {scale_type, values_type};
+        const char* member_names[2] = {"scale", "values"};
+        duckdb_logical_type struct_type = duckdb_create_struct_type(member_types, member_names, 2);
+        duckdb_scalar_function_set_return_type(function, struct_type);
+        duckdb_destroy_logical_type(&struct_type);
+        duckdb_destroy_logical_type(&values_type);
+        duckdb_destroy_logical_type(&tinyint_type);
+        duckdb_destroy_logical_type(&scale_type);
+        duckdb_scalar_function_set_function(function, llama_embed_i8_function);
+        duckdb_register_scalar_function(connection, function);
+        duckdb_destroy_scalar_function(&function);
+    }
+
+    {
+        // Binary sign-quantized embeddings: BLOB of packed sign bits for
+        // Hamming-distance retrieval, 32x smaller than the fp32 list.
+        duckdb_scalar_function function = duckdb_create_scalar_function();
+        duckdb_scalar_function_set_name(function, "trex_ai_embed_bit");
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_set_return_type(function, duckdb_create_logical_type(DUCKDB_TYPE_BLOB));
+        duckdb_scalar_function_set_function(function, llama_embed_bit_function);
+        duckdb_register_scalar_function(connection, function);
+        duckdb_destroy_scalar_function(&function);
+    }
+
     {
         duckdb_scalar_function function = duckdb_create_scalar_function();
         duckdb_scalar_function_set_name(function, "trex_ai_batch_process");
@@ -135,6 +196,16 @@ DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info
         duckdb_destroy_scalar_function(&function);
     }
 
+    {
+        duckdb_scalar_function function = duckdb_create_scalar_function();
+        duckdb_scalar_function_set_name(function, "trex_ai_batch_results_since");
+        duckdb_scalar_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+        duckdb_scalar_function_set_return_type(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_scalar_function_set_function(function, llama_batch_results_since_function);
+        duckdb_register_scalar_function(connection, function);
+        duckdb_destroy_scalar_function(&function);
+    }
+
     {
         duckdb_scalar_function function = duckdb_create_scalar_function();
         duckdb_scalar_function_set_name(function, "trex_ai_status");
@@ -172,6 +243,37 @@ DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info
         duckdb_destroy_scalar_function(&function);
     }
 
+    {
+        duckdb_table_function function = duckdb_create_table_function();
+        duckdb_table_function_set_name(function, "trex_ai_latency_metrics");
+        duckdb_table_function_set_bind(function, llama_latency_metrics_bind);
+        duckdb_table_function_set_init(function, llama_latency_metrics_init);
+        duckdb_table_function_set_function(function, llama_latency_metrics_function);
+        duckdb_register_table_function(connection, function);
+        duckdb_destroy_table_function(&function);
+    }
+
+    {
+        duckdb_table_function function = duckdb_create_table_function();
+        duckdb_table_function_set_name(function, "trex_ai_trace");
+        duckdb_table_function_set_bind(function, llama_trace_bind);
+        duckdb_table_function_set_init(function, llama_trace_init);
+        duckdb_table_function_set_function(function, llama_trace_function);
+        duckdb_register_table_function(connection, function);
+        duckdb_destroy_table_function(&function);
+    }
+
+    {
+        duckdb_table_function function = duckdb_create_table_function();
+        duckdb_table_function_set_name(function, "trex_ai_gguf_info");
+        duckdb_table_function_add_parameter(function, duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+        duckdb_table_function_set_bind(function, llama_gguf_info_bind);
+        duckdb_table_function_set_init(function, llama_gguf_info_init);
+        duckdb_table_function_set_function(function, llama_gguf_info_function);
+        duckdb_register_table_function(connection, function);
+        duckdb_destroy_table_function(&function);
+    }
+
     {
         duckdb_scalar_function function = duckdb_create_scalar_function();
         duckdb_scalar_function_set_name(function, "trex_ai_memory_status");
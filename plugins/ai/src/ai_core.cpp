@@ -1,12 +1,12 @@
 #include "include/ai_core.hpp"
 #include "../llama.cpp/include/llama.h"
+#include "ggml-backend.h"
 #include <iostream>
 #include <filesystem>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
-#include <unordered_set>
 
 namespace llama_capi {
 
@@ -62,8 +62,73 @@ size_t PerformanceSnapshot::GetMemoryUsageMB() const {
 }
 
 
-ContextPoolEntry::ContextPoolEntry() 
-    : context(nullptr), sampler(nullptr), in_use(false), usage_count(0) {
+// Bucket index is floor(log2(value_us)), clamped to the table. Relaxed
+// ordering is fine: samples are independent counters and readers only need
+// an eventually-consistent snapshot.
+void LatencyHistogram::Record(uint64_t value_us) {
+    size_t bucket = 63 - __builtin_clzll(value_us | 1);
+    if (bucket >= kBuckets) {
+        bucket = kBuckets - 1;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(value_us, std::memory_order_relaxed);
+
+    uint64_t prev_max = max_us_.load(std::memory_order_relaxed);
+    while (value_us > prev_max &&
+           !max_us_.compare_exchange_weak(prev_max, value_us, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::Count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::MeanMs() const {
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(sum_us_.load(std::memory_order_relaxed)) / count / 1000.0;
+}
+
+double LatencyHistogram::MaxMs() const {
+    return static_cast<double>(max_us_.load(std::memory_order_relaxed)) / 1000.0;
+}
+
+double LatencyHistogram::PercentileMs(double pct) const {
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t target = (uint64_t)(pct / 100.0 * count);
+    if (target < 1) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            // Report the bucket's upper bound so the estimate never
+            // understates the tail.
+            return static_cast<double>(2ULL << i) / 1000.0;
+        }
+    }
+    return MaxMs();
+}
+
+void LatencyHistogram::Reset() {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+
+ContextPoolEntry::ContextPoolEntry()
+    : context(nullptr), sampler(nullptr), in_use(false), usage_count(0), n_ctx(0), size_class(0) {
     last_used = std::chrono::steady_clock::now();
 }
 
@@ -85,64 +150,101 @@ ContextPool::ContextPool(llama_model* model, const ModelConfig& config, size_t m
 
 ContextPool::~ContextPool() {
     std::lock_guard<std::mutex> lock(pool_mutex_);
-    
-    while (!available_contexts_.empty()) {
-        available_contexts_.pop();
+
+    for (auto& free_list : free_lists_) {
+        free_list.clear();
     }
-    
-    all_contexts_.clear();
+    total_contexts_ = 0;
+    kv_bytes_ = 0;
+}
+
+size_t ContextPool::EstimateKVBytesPerToken() const {
+    if (!model_) return 0;
+    // One K and one V cell per layer; grouped-query models store
+    // n_head_kv/n_head of the embedding width. f16 cells unless the config
+    // asks for f32.
+    int n_layer = llama_model_n_layer(model_);
+    int n_embd = llama_model_n_embd(model_);
+    int n_head = llama_model_n_head(model_);
+    int n_head_kv = llama_model_n_head_kv(model_);
+    size_t n_embd_kv = (n_head > 0 && n_head_kv > 0)
+        ? (size_t)n_embd * n_head_kv / n_head
+        : (size_t)n_embd;
+    size_t cell_bytes = config_.memory_f16 ? 2 : 4;
+    return 2 * (size_t)n_layer * n_embd_kv * cell_bytes;
+}
+
+uint32_t ContextPool::ClassCtxSize(size_t size_class) const {
+    if (size_class + 1 >= kNumSizeClasses) {
+        return (uint32_t)config_.n_ctx;
+    }
+    // Small class: a quarter of the configured context, but never so small
+    // that a typical short prompt plus completion cannot fit.
+    uint32_t small = (uint32_t)config_.n_ctx / 4;
+    return small < 512 ? (uint32_t)config_.n_ctx : small;
+}
+
+size_t ContextPool::ClassForRequest(size_t min_ctx_tokens) const {
+    if (min_ctx_tokens == 0) {
+        return kNumSizeClasses - 1;  // unknown size: be conservative
+    }
+    for (size_t cls = 0; cls + 1 < kNumSizeClasses; ++cls) {
+        if (min_ctx_tokens <= ClassCtxSize(cls)) {
+            return cls;
+        }
+    }
+    return kNumSizeClasses - 1;
 }
 
-std::unique_ptr<ContextPoolEntry> ContextPool::AcquireContext() {
+std::unique_ptr<ContextPoolEntry> ContextPool::AcquireContext(size_t min_ctx_tokens) {
     std::lock_guard<std::mutex> lock(pool_mutex_);
-    
-    
-    if (!available_contexts_.empty()) {
-        ContextPoolEntry* raw_entry = available_contexts_.front();
-        available_contexts_.pop();
-        raw_entry->in_use = true;
-        raw_entry->last_used = std::chrono::steady_clock::now();
-        raw_entry->usage_count++;
-        
-        
-        for (auto it = all_contexts_.begin(); it != all_contexts_.end(); ++it) {
-            if (it->get() == raw_entry) {
-                auto result = std::move(*it);
-                all_contexts_.erase(it);
-                return result;
-            }
+
+    // Pop the best-fitting free list; any larger class also satisfies the
+    // request. Both the pop and the release push are O(1).
+    size_t wanted = ClassForRequest(min_ctx_tokens);
+    for (size_t cls = wanted; cls < kNumSizeClasses; ++cls) {
+        auto& free_list = free_lists_[cls];
+        if (!free_list.empty()) {
+            auto entry = std::move(free_list.back());
+            free_list.pop_back();
+            entry->in_use = true;
+            entry->last_used = std::chrono::steady_clock::now();
+            entry->usage_count++;
+            return entry;
         }
     }
-    
-    
-    if (all_contexts_.size() < max_pool_size_) {
-        return CreateNewContext();
+
+    if (total_contexts_ < max_pool_size_) {
+        auto entry = CreateNewContext(wanted);
+        if (entry) {
+            total_contexts_++;
+            kv_bytes_ += (size_t)entry->n_ctx * EstimateKVBytesPerToken();
+        }
+        return entry;
     }
-    
-    
+
     return nullptr;
 }
 
 void ContextPool::ReleaseContext(std::unique_ptr<ContextPoolEntry> entry) {
     if (!entry) return;
-    
+
     std::lock_guard<std::mutex> lock(pool_mutex_);
     entry->in_use = false;
     entry->last_used = std::chrono::steady_clock::now();
-    
-    
-    ContextPoolEntry* raw_ptr = entry.get();
-    available_contexts_.push(raw_ptr);
-    all_contexts_.push_back(std::move(entry));
+
+    size_t cls = entry->size_class < kNumSizeClasses ? entry->size_class : kNumSizeClasses - 1;
+    free_lists_[cls].push_back(std::move(entry));
 }
 
-std::unique_ptr<ContextPoolEntry> ContextPool::CreateNewContext() {
+std::unique_ptr<ContextPoolEntry> ContextPool::CreateNewContext(size_t size_class) {
     if (!model_) return nullptr;
-    
+
 
     llama_context_params ctx_params = llama_context_default_params();
-    ctx_params.n_ctx = config_.n_ctx;
+    ctx_params.n_ctx = ClassCtxSize(size_class);
     ctx_params.n_batch = config_.n_batch;
+    ctx_params.n_seq_max = config_.n_seq_max > 0 ? config_.n_seq_max : 1;
     ctx_params.n_threads = config_.n_threads;
     ctx_params.embeddings = config_.embeddings;
     ctx_params.offload_kqv = config_.n_gpu_layers > 0;
@@ -180,9 +282,11 @@ std::unique_ptr<ContextPoolEntry> ContextPool::CreateNewContext() {
     entry->sampler = sampler;
     entry->in_use = true;
     entry->usage_count = 1;
-    
-    
-    
+    entry->n_ctx = ctx_params.n_ctx;
+    entry->size_class = size_class;
+
+
+
     return entry;
 }
 
@@ -190,57 +294,68 @@ void ContextPool::CleanupExpiredContexts() {
     std::lock_guard<std::mutex> lock(pool_mutex_);
     auto now = std::chrono::steady_clock::now();
 
-    // Drain the queue, keeping track of which pointers remain available
-    std::unordered_set<ContextPoolEntry*> available_set;
-    std::queue<ContextPoolEntry*> new_queue;
-    while (!available_contexts_.empty()) {
-        ContextPoolEntry* entry = available_contexts_.front();
-        available_contexts_.pop();
-
-        if (now - entry->last_used < context_ttl_) {
-            new_queue.push(entry);
-            available_set.insert(entry);
-        }
-    }
-    available_contexts_ = std::move(new_queue);
-
-    // Only erase entries that are expired AND not still referenced in the queue
-    all_contexts_.erase(
-        std::remove_if(all_contexts_.begin(), all_contexts_.end(),
+    // Only free entries can expire; handed-out ones are owned by callers.
+    size_t kv_per_token = EstimateKVBytesPerToken();
+    for (auto& free_list : free_lists_) {
+        auto keep_end = std::remove_if(free_list.begin(), free_list.end(),
             [&](const std::unique_ptr<ContextPoolEntry>& ptr) {
-                if (ptr->in_use) return false;
-                if (available_set.count(ptr.get())) return false;
                 return (now - ptr->last_used) >= context_ttl_;
-            }),
-        all_contexts_.end());
+            });
+        for (auto it = keep_end; it != free_list.end(); ++it) {
+            total_contexts_--;
+            kv_bytes_ -= (size_t)(*it)->n_ctx * kv_per_token;
+        }
+        free_list.erase(keep_end, free_list.end());
+    }
 }
 
 size_t ContextPool::GetPoolSize() const {
     std::lock_guard<std::mutex> lock(pool_mutex_);
-    return all_contexts_.size();
+    return total_contexts_;
+}
+
+size_t ContextPool::GetMaxPoolSize() const {
+    return max_pool_size_;
+}
+
+size_t ContextPool::GetKVBytes() const {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    return kv_bytes_;
 }
 
 size_t ContextPool::GetAvailableCount() const {
     std::lock_guard<std::mutex> lock(pool_mutex_);
-    return available_contexts_.size();
+    size_t available = 0;
+    for (const auto& free_list : free_lists_) {
+        available += free_list.size();
+    }
+    return available;
 }
 
 
-LoadedModel::LoadedModel() 
-    : model(nullptr), reference_count(0), memory_usage_bytes(0) {
+LoadedModel::LoadedModel()
+    : model(nullptr), draft_model(nullptr), load_state(ModelLoadState::Loading),
+      load_id(0), reference_count(0), memory_usage_bytes(0) {
     load_time = std::chrono::steady_clock::now();
     last_access = load_time;
 }
 
 LoadedModel::~LoadedModel() {
-    
+
     if (context_pool) {
         context_pool.reset();
     }
-    
+    if (draft_pool) {
+        draft_pool.reset();
+    }
+
     if (model) {
         llama_model_free(model);
-        model = nullptr;  
+        model = nullptr;
+    }
+    if (draft_model) {
+        llama_model_free(draft_model);
+        draft_model = nullptr;
     }
 }
 
@@ -255,7 +370,8 @@ SimpleModelManager& SimpleModelManager::GetInstance() {
 SimpleModelManager::SimpleModelManager(size_t memory_limit_mb, size_t max_context_pool_size)
     : memory_limit_bytes_(memory_limit_mb * 1024 * 1024)
     , max_context_pool_size_(max_context_pool_size)
-    , background_cleanup_enabled_(false)  
+    , background_cleanup_enabled_(false)
+    , should_stop_batch_(false)
     , backend_initialized_(false) {
     
     
@@ -264,7 +380,37 @@ SimpleModelManager::SimpleModelManager(size_t memory_limit_mb, size_t max_contex
 
 SimpleModelManager::~SimpleModelManager() {
     background_cleanup_enabled_ = false;
-    
+
+    {
+        std::lock_guard<std::mutex> tlock(load_threads_mutex_);
+        for (auto& thread : load_threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        load_threads_.clear();
+    }
+
+    should_stop_batch_ = true;
+    batch_cv_.notify_all();
+    if (batch_processor_.joinable()) {
+        batch_processor_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stream_queue_mutex_);
+        should_stop_stream_workers_ = true;
+        stream_ready_.clear();
+        stream_queue_cv_.notify_all();
+    }
+    for (auto& worker : stream_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    stream_workers_.clear();
+    stream_workers_started_ = false;
+
     {
         std::lock_guard<std::mutex> streaming_lock(streaming_mutex_);
         for (auto& session_pair : streaming_sessions_) {
@@ -285,7 +431,7 @@ SimpleModelManager::~SimpleModelManager() {
     }
     
     {
-        std::lock_guard<std::mutex> lock(models_mutex_);
+        std::lock_guard<std::shared_mutex> lock(models_mutex_);
         models_.clear();
     }
 
@@ -311,82 +457,194 @@ bool SimpleModelManager::Initialize() {
 }
 
 bool SimpleModelManager::LoadModel(const std::string& model_name, const ModelConfig& config) {
-    std::lock_guard<std::mutex> lock(models_mutex_);
-    
-    if (!backend_initialized_ && !Initialize()) {
-        return false;
-    }
-    
-    
-    if (models_.find(model_name) != models_.end()) {
-        std::cout << "Model " << model_name << " already loaded" << std::endl;
-        return true;
-    }
-    
-    
-    if (models_.empty() && !cleanup_thread_.joinable()) {
-        background_cleanup_enabled_ = true;
-        cleanup_thread_ = std::thread(&SimpleModelManager::BackgroundCleanupWorker, this);
-    }
-    
-    
-    if (!CheckMemoryLimit()) {
-        std::cout << "Memory limit reached, cannot load model " << model_name << std::endl;
-        return false;
+    uint64_t load_id;
+    {
+        std::lock_guard<std::shared_mutex> lock(models_mutex_);
+
+        if (!backend_initialized_ && !Initialize()) {
+            return false;
+        }
+
+
+        if (models_.find(model_name) != models_.end()) {
+            std::cout << "Model " << model_name << " already loaded" << std::endl;
+            return true;
+        }
+
+
+        if (models_.empty() && !cleanup_thread_.joinable()) {
+            background_cleanup_enabled_ = true;
+            cleanup_thread_ = std::thread(&SimpleModelManager::BackgroundCleanupWorker, this);
+        }
+
+
+        if (!std::filesystem::exists(config.model_path)) {
+            std::cerr << "Model file not found: " << config.model_path << std::endl;
+            return false;
+        }
+
+        // Admission control against the GGUF file size — what mmap will
+        // actually map, quantization included. If the load would exceed the
+        // limit, evict idle models least-recently-used first before giving
+        // up.
+        if (memory_limit_bytes_ > 0) {
+            std::error_code ec;
+            size_t expected = (size_t)std::filesystem::file_size(config.model_path, ec);
+            if (ec) expected = 0;
+            while (metrics_.memory_usage_bytes.load() + expected > memory_limit_bytes_) {
+                if (!EvictLRUModel()) break;
+            }
+            if (metrics_.memory_usage_bytes.load() + expected > memory_limit_bytes_) {
+                std::cout << "Memory limit reached, cannot load model " << model_name << std::endl;
+                return false;
+            }
+        }
+
+        // Insert a Loading placeholder and return: the map mutation is the
+        // only thing that happens under models_mutex_, so calls against
+        // other, already-loaded models never stall behind a multi-second GGUF
+        // load, and several loads can run in parallel.
+        static std::atomic<uint64_t> next_load_id{1};
+        auto placeholder = std::make_unique<LoadedModel>();
+        placeholder->config = config;
+        placeholder->load_state = ModelLoadState::Loading;
+        placeholder->load_id = next_load_id.fetch_add(1);
+        load_id = placeholder->load_id;
+        models_[model_name] = std::move(placeholder);
     }
 
-    std::string model_path = config.model_path;
-    if (!std::filesystem::exists(model_path)) {
-        std::cerr << "Model file not found: " << model_path << std::endl;
-        return false;
+    {
+        std::lock_guard<std::mutex> tlock(load_threads_mutex_);
+        load_threads_.emplace_back(&SimpleModelManager::LoadModelWorker, this, model_name, config, load_id);
     }
+    return true;
+}
 
-    
+void SimpleModelManager::LoadModelWorker(std::string model_name, ModelConfig config, uint64_t load_id) {
     llama_model_params model_params = llama_model_default_params();
     model_params.n_gpu_layers = config.n_gpu_layers;
     model_params.use_mmap = config.use_mmap;
     model_params.use_mlock = config.use_mlock;
+    model_params.main_gpu = config.main_gpu;
+
+    // Per-model layer placement. llama.cpp reads llama_max_devices() floats
+    // from tensor_split, so the configured proportions are copied into a
+    // zero-padded buffer that stays alive for the duration of the load.
+    std::vector<float> split(llama_max_devices(), 0.0f);
+    if (!config.tensor_split.empty()) {
+        size_t n = std::min(config.tensor_split.size(), split.size());
+        std::copy(config.tensor_split.begin(), config.tensor_split.begin() + n, split.begin());
+        model_params.split_mode = LLAMA_SPLIT_MODE_LAYER;
+        model_params.tensor_split = split.data();
+    }
 
-    
-    llama_model* model = llama_model_load_from_file(model_path.c_str(), model_params);
+    // The expensive part runs without any manager lock held.
+    llama_model* model = llama_model_load_from_file(config.model_path.c_str(), model_params);
+
+    // Optional draft model for speculative decoding. It is loaded with the
+    // same mmap/mlock/GPU settings as the target; the vocabularies must match
+    // or greedy verification would compare tokens from different id spaces,
+    // so a mismatched draft is dropped rather than used.
+    llama_model* draft = nullptr;
+    if (model && !config.draft_model_path.empty()) {
+        if (!std::filesystem::exists(config.draft_model_path)) {
+            std::cerr << "Draft model file not found: " << config.draft_model_path << std::endl;
+        } else {
+            llama_model_params draft_params = llama_model_default_params();
+            draft_params.n_gpu_layers = config.n_gpu_layers;
+            draft_params.use_mmap = config.use_mmap;
+            draft_params.use_mlock = config.use_mlock;
+            draft_params.main_gpu = config.main_gpu;
+            if (!config.tensor_split.empty()) {
+                draft_params.split_mode = LLAMA_SPLIT_MODE_LAYER;
+                draft_params.tensor_split = split.data();
+            }
+
+            draft = llama_model_load_from_file(config.draft_model_path.c_str(), draft_params);
+            if (!draft) {
+                std::cerr << "Failed to load draft model from: " << config.draft_model_path << std::endl;
+            } else if (llama_vocab_n_tokens(llama_model_get_vocab(draft)) !=
+                       llama_vocab_n_tokens(llama_model_get_vocab(model))) {
+                std::cerr << "Draft model vocab does not match " << model_name
+                          << ", speculative decoding disabled" << std::endl;
+                llama_model_free(draft);
+                draft = nullptr;
+            }
+        }
+    }
+
+    std::lock_guard<std::shared_mutex> lock(models_mutex_);
+
+    auto it = models_.find(model_name);
+    if (it == models_.end() || it->second->load_id != load_id) {
+        // The entry was unloaded (or unloaded and re-requested) while we were
+        // loading; this result has no owner any more.
+        if (model) llama_model_free(model);
+        if (draft) llama_model_free(draft);
+        models_cv_.notify_all();
+        return;
+    }
+
+    LoadedModel& entry = *it->second;
     if (!model) {
-        std::cerr << "Failed to load model from: " << model_path << std::endl;
-        return false;
+        entry.load_error = "Failed to load model from: " + config.model_path;
+        entry.load_state = ModelLoadState::Failed;
+        std::cerr << entry.load_error << std::endl;
+        models_cv_.notify_all();
+        return;
     }
 
-    
-    auto loaded_model = std::make_unique<LoadedModel>();
-    loaded_model->model = model;
-    loaded_model->config = config;
-    loaded_model->context_pool = std::make_unique<ContextPool>(model, config, max_context_pool_size_);
-    
-    
+    entry.model = model;
+    entry.context_pool = std::make_unique<ContextPool>(model, config, max_context_pool_size_);
+
     size_t model_size = EstimateModelMemoryUsage(model);
-    loaded_model->memory_usage_bytes = model_size;
-    metrics_.memory_usage_bytes += model_size;
-    metrics_.peak_memory_bytes = std::max(
-        metrics_.peak_memory_bytes.load(), 
-        metrics_.memory_usage_bytes.load()
-    );
+    if (draft) {
+        entry.draft_model = draft;
+        ModelConfig draft_config = config;
+        draft_config.model_path = config.draft_model_path;
+        draft_config.draft_model_path.clear();
+        entry.draft_pool = std::make_unique<ContextPool>(draft, draft_config, max_context_pool_size_);
+        model_size += EstimateModelMemoryUsage(draft);
+    }
 
-    
-    models_[model_name] = std::move(loaded_model);
-    
-    std::cout << "Successfully loaded model: " << model_name 
+    entry.memory_usage_bytes = model_size;
+    RecomputeMemoryMetric();
+
+    entry.load_state = ModelLoadState::Ready;
+    std::cout << "Successfully loaded model: " << model_name
               << " (estimated " << (model_size / 1024 / 1024) << " MB)" << std::endl;
-    return true;
+    models_cv_.notify_all();
 }
 
 bool SimpleModelManager::UnloadModel(const std::string& model_name) {
     std::unique_ptr<LoadedModel> model_to_unload;
     {
-        std::lock_guard<std::mutex> lock(models_mutex_);
+        std::lock_guard<std::shared_mutex> lock(models_mutex_);
         auto it = models_.find(model_name);
         if (it == models_.end()) {
             return false;
         }
         model_to_unload = std::move(it->second);
         models_.erase(it);
+        RecomputeMemoryMetric();
+    }
+    // Wake GetModel callers waiting on this entry's (now abandoned) load.
+    models_cv_.notify_all();
+
+    // Cached deterministic responses are keyed by model name; the same name
+    // could come back with different weights, so drop them now.
+    {
+        std::lock_guard<std::mutex> lock(gen_cache_mutex_);
+        for (auto it = gen_cache_lru_.begin(); it != gen_cache_lru_.end();) {
+            if (it->model == model_name) {
+                gen_cache_bytes_ -= sizeof(CachedGeneration) + it->model.size() +
+                                    it->prompt.size() + it->response.size();
+                gen_cache_index_.erase(it->key);
+                it = gen_cache_lru_.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
     // Wait for outstanding references without holding models_mutex_
@@ -414,41 +672,67 @@ bool SimpleModelManager::UnloadModel(const std::string& model_name) {
         model_to_unload->context_pool.reset();
     }
 
-    metrics_.memory_usage_bytes -= model_to_unload->memory_usage_bytes;
     std::cout << "Unloaded model: " << model_name << std::endl;
     return true;
 }
 
 std::shared_ptr<LoadedModel> SimpleModelManager::GetModel(const std::string& model_name) {
-    std::lock_guard<std::mutex> lock(models_mutex_);
-    auto it = models_.find(model_name);
-    if (it == models_.end()) {
-        return nullptr;
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
+    for (;;) {
+        auto it = models_.find(model_name);
+        if (it == models_.end()) {
+            return nullptr;
+        }
+
+        ModelLoadState state = it->second->load_state.load();
+        if (state == ModelLoadState::Failed) {
+            return nullptr;
+        }
+        if (state == ModelLoadState::Ready) {
+            auto& loaded_model = it->second;
+            loaded_model->reference_count++;
+            loaded_model->last_access = std::chrono::steady_clock::now();
+
+            return std::shared_ptr<LoadedModel>(loaded_model.get(), [this, model_name](LoadedModel* model) {
+                ReleaseModelReference(model_name);
+            });
+        }
+
+        // Load still in flight: wait for the worker instead of failing calls
+        // issued right after LoadModel returned.
+        models_cv_.wait(lock);
     }
-    
-    auto& loaded_model = it->second;
-    loaded_model->reference_count++;
-    loaded_model->last_access = std::chrono::steady_clock::now();
-    
-    return std::shared_ptr<LoadedModel>(loaded_model.get(), [this, model_name](LoadedModel* model) {
-        ReleaseModelReference(model_name);
-    });
 }
 
 // GetModelRaw removed — returned a dangling pointer from a local shared_ptr
 
 bool SimpleModelManager::IsModelLoaded(const std::string& model_name) const {
-    std::lock_guard<std::mutex> lock(models_mutex_);
-    return models_.find(model_name) != models_.end();
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
+    auto it = models_.find(model_name);
+    return it != models_.end() && it->second->load_state.load() == ModelLoadState::Ready;
+}
+
+std::string SimpleModelManager::GetModelLoadStatus(const std::string& model_name) const {
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
+    auto it = models_.find(model_name);
+    if (it == models_.end()) {
+        return "not_loaded";
+    }
+    switch (it->second->load_state.load()) {
+        case ModelLoadState::Loading: return "loading";
+        case ModelLoadState::Ready:   return "ready";
+        case ModelLoadState::Failed:  return "failed: " + it->second->load_error;
+    }
+    return "unknown";
 }
 
 size_t SimpleModelManager::GetLoadedModelCount() const {
-    std::lock_guard<std::mutex> lock(models_mutex_);
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
     return models_.size();
 }
 
 std::vector<std::string> SimpleModelManager::GetLoadedModelNames() const {
-    std::lock_guard<std::mutex> lock(models_mutex_);
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
     std::vector<std::string> names;
     names.reserve(models_.size());
     for (const auto& pair : models_) {
@@ -469,20 +753,96 @@ PerformanceSnapshot SimpleModelManager::GetMetrics() const {
     return result;
 }
 
+ModelLatencyMetrics& SimpleModelManager::GetLatencyMetrics(const std::string& model_name) {
+    std::lock_guard<std::mutex> lock(latency_metrics_mutex_);
+    auto& slot = latency_metrics_[model_name];
+    if (!slot) {
+        slot = std::make_unique<ModelLatencyMetrics>();
+    }
+    return *slot;
+}
+
+std::vector<LatencyRow> SimpleModelManager::GetLatencySnapshot() const {
+    std::vector<LatencyRow> rows;
+    std::lock_guard<std::mutex> lock(latency_metrics_mutex_);
+    for (const auto& pair : latency_metrics_) {
+        const ModelLatencyMetrics& m = *pair.second;
+        const std::pair<const char*, const LatencyHistogram*> phases[] = {
+            {"prefill", &m.prefill},
+            {"decode", &m.decode},
+            {"ttft", &m.ttft},
+            {"e2e", &m.e2e},
+        };
+        for (const auto& phase : phases) {
+            const LatencyHistogram& h = *phase.second;
+            if (h.Count() == 0) {
+                continue;
+            }
+            LatencyRow row;
+            row.model = pair.first;
+            row.metric = phase.first;
+            row.count = h.Count();
+            row.mean_ms = h.MeanMs();
+            row.p50_ms = h.PercentileMs(50.0);
+            row.p95_ms = h.PercentileMs(95.0);
+            row.p99_ms = h.PercentileMs(99.0);
+            row.max_ms = h.MaxMs();
+            rows.push_back(std::move(row));
+        }
+    }
+    return rows;
+}
+
 void SimpleModelManager::ResetMetrics() {
     metrics_.Reset();
+    std::lock_guard<std::mutex> lock(latency_metrics_mutex_);
+    for (auto& pair : latency_metrics_) {
+        pair.second->prefill.Reset();
+        pair.second->decode.Reset();
+        pair.second->ttft.Reset();
+        pair.second->e2e.Reset();
+    }
 }
 
 void SimpleModelManager::Cleanup() {
-    
+
     background_cleanup_enabled_ = false;
-    
-    
+
+    {
+        std::lock_guard<std::mutex> tlock(load_threads_mutex_);
+        for (auto& thread : load_threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        load_threads_.clear();
+    }
+
     if (cleanup_thread_.joinable()) {
         cleanup_thread_.join();
     }
+
+    should_stop_batch_ = true;
+    batch_cv_.notify_all();
+    if (batch_processor_.joinable()) {
+        batch_processor_.join();
+    }
     
     
+    {
+        std::lock_guard<std::mutex> lock(stream_queue_mutex_);
+        should_stop_stream_workers_ = true;
+        stream_ready_.clear();
+        stream_queue_cv_.notify_all();
+    }
+    for (auto& worker : stream_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    stream_workers_.clear();
+    stream_workers_started_ = false;
+
     {
         std::lock_guard<std::mutex> streaming_lock(streaming_mutex_);
         for (auto& session_pair : streaming_sessions_) {
@@ -495,7 +855,7 @@ void SimpleModelManager::Cleanup() {
     
     
     {
-        std::lock_guard<std::mutex> lock(models_mutex_);
+        std::lock_guard<std::shared_mutex> lock(models_mutex_);
         models_.clear();
     }
     
@@ -514,178 +874,813 @@ size_t SimpleModelManager::GetTotalMemoryUsage() const {
 }
 
 void SimpleModelManager::ReleaseModelReference(const std::string& model_name) {
-    std::lock_guard<std::mutex> lock(models_mutex_);
+    std::shared_lock<std::shared_mutex> lock(models_mutex_);
     auto it = models_.find(model_name);
     if (it != models_.end()) {
         it->second->reference_count--;
     }
 }
 
+// Caller holds models_mutex_ (shared suffices; the metric itself is atomic).
+// Sums real model bytes plus each pool's live KV-cache estimate, so the
+// accounting follows contexts as they are created and expire.
+void SimpleModelManager::RecomputeMemoryMetric() {
+    size_t total = 0;
+    for (const auto& pair : models_) {
+        total += pair.second->memory_usage_bytes;
+        if (pair.second->context_pool) {
+            total += pair.second->context_pool->GetKVBytes();
+        }
+        if (pair.second->draft_pool) {
+            total += pair.second->draft_pool->GetKVBytes();
+        }
+    }
+    metrics_.memory_usage_bytes = total;
+    metrics_.peak_memory_bytes = std::max(
+        metrics_.peak_memory_bytes.load(),
+        (uint64_t)total
+    );
+}
+
+// Caller holds models_mutex_ exclusively. Frees the least-recently-used
+// idle model; returns false when nothing is evictable (everything in use,
+// loading, or the map is empty).
+bool SimpleModelManager::EvictLRUModel() {
+    auto lru = models_.end();
+    auto lru_access = std::chrono::steady_clock::time_point::max();
+    for (auto it = models_.begin(); it != models_.end(); ++it) {
+        auto& candidate = *it->second;
+        if (candidate.load_state.load() != ModelLoadState::Ready) continue;
+        if (candidate.reference_count.load() > 0) continue;
+        auto accessed = candidate.last_access.load();
+        if (accessed < lru_access) {
+            lru_access = accessed;
+            lru = it;
+        }
+    }
+    if (lru == models_.end()) {
+        return false;
+    }
+
+    std::cout << "Evicting least-recently-used model: " << lru->first << std::endl;
+    models_.erase(lru);  // LoadedModel destructor frees pools and weights
+    RecomputeMemoryMetric();
+    return true;
+}
+
 bool SimpleModelManager::CheckMemoryLimit() const {
     return memory_limit_bytes_ == 0 || metrics_.memory_usage_bytes < memory_limit_bytes_;
 }
 
 size_t SimpleModelManager::EstimateModelMemoryUsage(llama_model* model) const {
     if (!model) return 0;
-    
-    
-    size_t n_params = llama_model_n_params(model);
-    size_t bytes_per_param = 2; 
-    
-    return n_params * bytes_per_param;
-}
 
-void SimpleModelManager::ConfigureSampler(llama_sampler* sampler, const GenerationParams& params) {
-    if (!sampler) return;
-    
-    
-    llama_sampler_reset(sampler);
-    
-    
-    
-    
-    
-    
-    
-    
+    // Actual bytes of the mapped tensor data; unlike the old n_params * 2
+    // guess this is right for quantized models (a Q4 13B is ~7 GB, not 26).
+    return llama_model_size(model);
 }
 
-void SimpleModelManager::BackgroundCleanupWorker() {
-    while (background_cleanup_enabled_) {
-        
-        for (int i = 0; i < 300 && background_cleanup_enabled_; ++i) { 
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+// Hash of the fields that shape a sampler chain (max_tokens, stream and
+// stop sequences are applied outside the chain and excluded on purpose).
+static uint64_t HashSamplerParams(const GenerationParams& params) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
         }
-        
-        if (!background_cleanup_enabled_) break;
-        
-        
-        std::lock_guard<std::mutex> lock(models_mutex_);
-        for (auto& pair : models_) {
-            if (pair.second->context_pool) {
-                pair.second->context_pool->CleanupExpiredContexts();
-            }
-        }
-    }
+    };
+    mix(&params.temperature, sizeof(params.temperature));
+    mix(&params.top_p, sizeof(params.top_p));
+    mix(&params.top_k, sizeof(params.top_k));
+    mix(&params.repeat_penalty, sizeof(params.repeat_penalty));
+    mix(&params.repeat_last_n, sizeof(params.repeat_last_n));
+    mix(&params.seed, sizeof(params.seed));
+    return hash;
 }
 
-std::string SimpleModelManager::Generate(const std::string& model_name, 
-                                       const std::string& prompt, 
-                                       const GenerationParams& params) {
-    auto model = GetModel(model_name);
-    if (!model) {
-        return "Error: Model not found: " + model_name;
+void SimpleModelManager::ConfigureSampler(ContextPoolEntry* entry, const GenerationParams& params) {
+    if (!entry) return;
+
+    // A pooled entry usually sees the same parameters request after request
+    // (per-row scans reuse one options literal), so the compiled chain is
+    // kept until the parameters actually change; a match only clears the
+    // chain's internal state (penalty windows, RNG position).
+    uint64_t hash = HashSamplerParams(params);
+    if (entry->sampler && entry->sampler_params_hash == hash) {
+        llama_sampler_reset(entry->sampler);
+        return;
     }
 
-    
-    auto context_entry = model->context_pool->AcquireContext();
+    llama_sampler* chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    if (!chain) return;
+
+    if (params.temperature <= 0.0f) {
+        // Pure argmax: no penalties, no distribution work. This is the
+        // common SQL-embedded mode and also what the speculative and batch
+        // greedy paths assume.
+        llama_sampler_chain_add(chain, llama_sampler_init_greedy());
+    } else {
+        if (params.repeat_penalty != 1.0f) {
+            llama_sampler_chain_add(chain, llama_sampler_init_penalties(
+                params.repeat_last_n, params.repeat_penalty, 0.0f, 0.0f));
+        }
+        llama_sampler_chain_add(chain, llama_sampler_init_top_k(params.top_k));
+        llama_sampler_chain_add(chain, llama_sampler_init_top_p(params.top_p, 1));
+        llama_sampler_chain_add(chain, llama_sampler_init_temp(params.temperature));
+        llama_sampler_chain_add(chain, llama_sampler_init_dist(params.seed >= 0 ? (uint32_t)params.seed : 12345));
+    }
+
+    if (entry->sampler) {
+        llama_sampler_free(entry->sampler);
+    }
+    entry->sampler = chain;
+    entry->sampler_params_hash = hash;
+}
+
+static std::vector<int32_t> TokenizeRaw(const llama_vocab* vocab, const std::string& text, bool add_special) {
+    std::vector<llama_token> tokens(text.length() + 100);
+    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(),
+                                tokens.data(), tokens.size(), add_special, true);
+    if (n_tokens < 0) {
+        tokens.resize(-n_tokens);
+        n_tokens = llama_tokenize(vocab, text.c_str(), text.length(),
+                                tokens.data(), tokens.size(), add_special, true);
+    }
+    if (n_tokens <= 0) {
+        return {};
+    }
+    tokens.resize(n_tokens);
+    return tokens;
+}
+
+static uint64_t TokenCacheHash(const llama_vocab* vocab, const std::string& prompt, bool add_special) {
+    uint64_t h = std::hash<std::string>{}(prompt);
+    h ^= (uint64_t)(uintptr_t)vocab + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return add_special ? ~h : h;
+}
+
+std::vector<int32_t> SimpleModelManager::TokenizeWithCache(const llama_vocab* vocab,
+                                                           const std::string& prompt,
+                                                           bool add_special) {
+    // Both lambdas expect token_cache_mutex_ to be held.
+    auto lookup = [&](const std::string& text) -> std::vector<int32_t>* {
+        auto it = token_cache_index_.find(TokenCacheHash(vocab, text, add_special));
+        if (it == token_cache_index_.end()) return nullptr;
+        if (it->second->prompt != text || it->second->vocab != vocab ||
+            it->second->add_special != add_special) {
+            return nullptr;  // hash collision; treat as a miss
+        }
+        token_cache_lru_.splice(token_cache_lru_.begin(), token_cache_lru_, it->second);
+        return &it->second->tokens;
+    };
+    auto insert = [&](const std::string& text, std::vector<int32_t> tokens) {
+        uint64_t hash = TokenCacheHash(vocab, text, add_special);
+        auto it = token_cache_index_.find(hash);
+        if (it != token_cache_index_.end()) {
+            token_cache_lru_.erase(it->second);
+            token_cache_index_.erase(it);
+        }
+        while (token_cache_lru_.size() >= kTokenCacheMaxEntries) {
+            auto& oldest = token_cache_lru_.back();
+            token_cache_index_.erase(TokenCacheHash(oldest.vocab, oldest.prompt, oldest.add_special));
+            token_cache_lru_.pop_back();
+        }
+        token_cache_lru_.push_front(CachedTokens{text, vocab, add_special, std::move(tokens)});
+        token_cache_index_[hash] = token_cache_lru_.begin();
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(token_cache_mutex_);
+        if (auto* hit = lookup(prompt)) {
+            return *hit;
+        }
+    }
+
+    // Exact hits only: stitching cached prefix tokens onto a freshly
+    // tokenized suffix is not equivalent to tokenizing the whole prompt for
+    // byte-level BPE (a leading space merges into the next token when
+    // tokenized cold), so a warm cache would change generated output.
+    // Tokenize outside the lock; concurrent rows should not serialize here.
+    std::vector<int32_t> tokens = TokenizeRaw(vocab, prompt, add_special);
+
+    if (!tokens.empty()) {
+        std::lock_guard<std::mutex> lock(token_cache_mutex_);
+        insert(prompt, tokens);
+    }
+    return tokens;
+}
+
+void SimpleModelManager::BackgroundCleanupWorker() {
+    while (background_cleanup_enabled_) {
+        
+        for (int i = 0; i < 300 && background_cleanup_enabled_; ++i) { 
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        
+        if (!background_cleanup_enabled_) break;
+        
+        
+        std::shared_lock<std::shared_mutex> lock(models_mutex_);
+        for (auto& pair : models_) {
+            if (pair.second->context_pool) {
+                pair.second->context_pool->CleanupExpiredContexts();
+            }
+            if (pair.second->draft_pool) {
+                pair.second->draft_pool->CleanupExpiredContexts();
+            }
+        }
+        // Expired contexts released their KV memory; refresh the metric.
+        RecomputeMemoryMetric();
+
+        // Age out batch results nobody ever collected.
+        {
+            std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+            EvictBatchResults();
+        }
+    }
+}
+
+bool SimpleModelManager::LookupGenerationCache(uint64_t key, const std::string& model_name,
+                                               const std::string& prompt, uint64_t params_hash,
+                                               std::string& response) {
+    std::lock_guard<std::mutex> lock(gen_cache_mutex_);
+    auto it = gen_cache_index_.find(key);
+    if (it == gen_cache_index_.end()) {
+        return false;
+    }
+    CachedGeneration& entry = *it->second;
+    if (entry.model != model_name || entry.params_hash != params_hash || entry.prompt != prompt) {
+        return false;
+    }
+    gen_cache_lru_.splice(gen_cache_lru_.begin(), gen_cache_lru_, it->second);
+    response = entry.response;
+    return true;
+}
+
+void SimpleModelManager::StoreGenerationCache(uint64_t key, const std::string& model_name,
+                                              const std::string& prompt, uint64_t params_hash,
+                                              const std::string& response) {
+    size_t bytes = sizeof(CachedGeneration) + model_name.size() + prompt.size() + response.size();
+
+    std::lock_guard<std::mutex> lock(gen_cache_mutex_);
+    if (bytes > gen_cache_max_bytes_) {
+        return;
+    }
+    if (gen_cache_index_.count(key)) {
+        // Another worker generated the same row concurrently; keep its entry.
+        return;
+    }
+    gen_cache_lru_.push_front({key, model_name, prompt, params_hash, response});
+    gen_cache_index_[key] = gen_cache_lru_.begin();
+    gen_cache_bytes_ += bytes;
+
+    while (gen_cache_bytes_ > gen_cache_max_bytes_ && !gen_cache_lru_.empty()) {
+        CachedGeneration& victim = gen_cache_lru_.back();
+        gen_cache_bytes_ -= sizeof(CachedGeneration) + victim.model.size() +
+                            victim.prompt.size() + victim.response.size();
+        gen_cache_index_.erase(victim.key);
+        gen_cache_lru_.pop_back();
+    }
+}
+
+void SimpleModelManager::SetGenerationCacheBudget(size_t limit_mb) {
+    std::lock_guard<std::mutex> lock(gen_cache_mutex_);
+    gen_cache_max_bytes_ = limit_mb * 1024 * 1024;
+    while (gen_cache_bytes_ > gen_cache_max_bytes_ && !gen_cache_lru_.empty()) {
+        CachedGeneration& victim = gen_cache_lru_.back();
+        gen_cache_bytes_ -= sizeof(CachedGeneration) + victim.model.size() +
+                            victim.prompt.size() + victim.response.size();
+        gen_cache_index_.erase(victim.key);
+        gen_cache_lru_.pop_back();
+    }
+}
+
+std::string SimpleModelManager::Generate(const std::string& model_name,
+                                       const std::string& prompt,
+                                       const GenerationParams& params) {
+    auto model = GetModel(model_name);
+    if (!model) {
+        return "Error: Model not found: " + model_name;
+    }
+
+    // Deterministic requests are pure functions of their inputs, so check
+    // the result cache before spending a pooled context on a repeat. Sampled
+    // (temperature > 0) requests are intentionally never cached.
+    const bool cacheable = params.temperature <= 0.0f && gen_cache_max_bytes_ > 0;
+    uint64_t cache_key = 0;
+    uint64_t cache_params_hash = 0;
+    if (cacheable) {
+        // max_tokens is excluded from the sampler hash but truncates the
+        // output, so it has to be part of the result key.
+        cache_params_hash = HashSamplerParams(params) ^ ((uint64_t)params.max_tokens * 1099511628211ULL);
+        cache_key = cache_params_hash;
+        auto mix = [&cache_key](const std::string& s) {
+            for (unsigned char c : s) {
+                cache_key ^= c;
+                cache_key *= 1099511628211ULL;
+            }
+        };
+        mix(model_name);
+        mix(prompt);
+
+        std::string cached;
+        if (LookupGenerationCache(cache_key, model_name, prompt, cache_params_hash, cached)) {
+            return cached;
+        }
+    }
+
+    // Greedy requests on models paired with a draft take the speculative
+    // path; sampled requests keep the plain loop since exact-match
+    // verification only reproduces the target's greedy output.
+    if (model->draft_model && model->draft_pool && params.temperature <= 0.0f) {
+        std::string response = GenerateSpeculative(model_name, model, prompt, params);
+        if (cacheable && response.rfind("Error:", 0) != 0) {
+            StoreGenerationCache(cache_key, model_name, prompt, cache_params_hash, response);
+        }
+        return response;
+    }
+
+
+    // Byte length bounds the token count for typical text, so this hint lets
+    // short requests run on a small context instead of a full-size one.
+    size_t ctx_hint = prompt.length() + (params.max_tokens > 0 ? (size_t)params.max_tokens : 0) + 8;
+    auto context_entry = model->context_pool->AcquireContext(ctx_hint);
     if (!context_entry) {
         return "Error: No available context for model: " + model_name;
     }
 
     auto start_time = std::chrono::steady_clock::now();
     metrics_.total_requests++;
+    auto& latency = GetLatencyMetrics(model_name);
 
     try {
-        
-        ConfigureSampler(context_entry->sampler, params);
+
+        ConfigureSampler(context_entry.get(), params);
         
         
         const llama_vocab* vocab = llama_model_get_vocab(model->model);
-        
-        
-        std::vector<llama_token> tokens(prompt.length() + 100);
-        int n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), 
-                                    tokens.data(), tokens.size(), true, true);
-        if (n_tokens < 0) {
-            tokens.resize(-n_tokens);
-            n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), 
-                                    tokens.data(), tokens.size(), true, true);
-        }
-        if (n_tokens <= 0) {
+
+
+        std::vector<llama_token> tokens = TokenizeWithCache(vocab, prompt, true);
+        if (tokens.empty()) {
             model->context_pool->ReleaseContext(std::move(context_entry));
             return "Error: Failed to tokenize prompt";
         }
-        tokens.resize(n_tokens);
 
-        
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
+        // Prompt-prefix KV reuse: a pooled context keeps the tokens of its
+        // previous request decoded. When this prompt shares a prefix (the
+        // common case for per-row scans with a fixed system prompt), drop only
+        // the divergent KV tail and decode the suffix instead of the whole
+        // prompt. At least one token is always re-decoded so fresh logits
+        // exist for sampling.
+        size_t common_prefix = 0;
+        while (common_prefix < context_entry->kv_tokens.size() &&
+               common_prefix < tokens.size() &&
+               context_entry->kv_tokens[common_prefix] == tokens[common_prefix]) {
+            common_prefix++;
+        }
+        if (common_prefix >= tokens.size()) {
+            common_prefix = tokens.size() - 1;
+        }
+
+        if (common_prefix > 0) {
+            llama_kv_self_seq_rm(context_entry->context, 0, (llama_pos)common_prefix, -1);
+        } else {
+            llama_kv_self_clear(context_entry->context);
+        }
+
+        // llama_batch_get_one continues positions from the sequence's KV end,
+        // so the suffix lands at positions [common_prefix, n_tokens).
+        llama_batch batch = llama_batch_get_one(tokens.data() + common_prefix,
+                                                tokens.size() - common_prefix);
+
 
-        
         if (llama_decode(context_entry->context, batch) != 0) {
+            context_entry->kv_tokens.clear();
             model->context_pool->ReleaseContext(std::move(context_entry));
             return "Error: Failed to process prompt";
         }
 
+        auto prefill_done = std::chrono::steady_clock::now();
+        latency.prefill.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(prefill_done - start_time).count());
+
+        context_entry->kv_tokens = tokens;
+
         std::string result;
         int tokens_generated = 0;
-        
-        
+
+
         for (int i = 0; i < params.max_tokens; ++i) {
-            
+
             llama_token new_token = llama_sampler_sample(context_entry->sampler, context_entry->context, -1);
-            
-            
+
+
             if (llama_vocab_is_eog(vocab, new_token)) {
                 break;
             }
 
-            
+
             char piece[256];
             int n = llama_token_to_piece(vocab, new_token, piece, sizeof(piece), 0, true);
             if (n > 0) {
                 result.append(piece, n);
                 tokens_generated++;
+                if (tokens_generated == 1) {
+                    latency.ttft.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start_time).count());
+                }
             }
 
-            
+
             llama_sampler_accept(context_entry->sampler, new_token);
 
-            
+
             llama_batch next_batch = llama_batch_get_one(&new_token, 1);
-            
-            
+
+
+            auto decode_start = std::chrono::steady_clock::now();
             if (llama_decode(context_entry->context, next_batch) != 0) {
+                context_entry->kv_tokens.clear();
                 break;
             }
+            latency.decode.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - decode_start).count());
+
+            context_entry->kv_tokens.push_back(new_token);
         }
 
-        
+
         auto end_time = std::chrono::steady_clock::now();
         auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
         metrics_.total_generation_time_ms += duration_ms;
         metrics_.total_tokens_generated += tokens_generated;
+        latency.e2e.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+
 
-        
         model->context_pool->ReleaseContext(std::move(context_entry));
 
+        if (cacheable) {
+            StoreGenerationCache(cache_key, model_name, prompt, cache_params_hash, result);
+        }
         return result;
-        
+
     } catch (const std::exception& e) {
-        
+
         model->context_pool->ReleaseContext(std::move(context_entry));
         std::cerr << "Generation error: " << e.what() << std::endl;
         return "Error: " + std::string(e.what());
     }
 }
 
-std::string SimpleModelManager::ChatCompletion(const std::string& model_name, 
-                                              const std::vector<ChatMessage>& messages, 
+// Speculative decoding: the draft model proposes a short run of tokens and
+// the target verifies the whole run with one batched decode, so accepted
+// tokens cost roughly one target forward pass per run instead of one per
+// token. Verification is exact-match against the target's greedy choice,
+// which is why Generate only routes temperature <= 0 requests here — the
+// output is bit-identical to what the plain greedy loop would produce.
+std::string SimpleModelManager::GenerateSpeculative(const std::string& model_name,
+                                                    std::shared_ptr<LoadedModel> model,
+                                                    const std::string& prompt,
+                                                    const GenerationParams& params) {
+    size_t ctx_hint = prompt.length() + (params.max_tokens > 0 ? (size_t)params.max_tokens : 0) + 8;
+    auto context_entry = model->context_pool->AcquireContext(ctx_hint);
+    if (!context_entry) {
+        return "Error: No available context for model";
+    }
+    auto draft_entry = model->draft_pool->AcquireContext(ctx_hint);
+    if (!draft_entry) {
+        model->context_pool->ReleaseContext(std::move(context_entry));
+        return "Error: No available draft context for model";
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    metrics_.total_requests++;
+    auto& latency = GetLatencyMetrics(model_name);
+
+    llama_context* tgt_ctx = context_entry->context;
+    llama_context* dft_ctx = draft_entry->context;
+    const llama_vocab* vocab = llama_model_get_vocab(model->model);
+
+    // Both models pick their single most likely token, so one stateless
+    // greedy chain serves target and draft alike.
+    llama_sampler* greedy = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    llama_sampler_chain_add(greedy, llama_sampler_init_greedy());
+
+    llama_batch verify_batch = {};
+    bool verify_batch_owned = false;
+
+    auto release_all = [&]() {
+        if (verify_batch_owned) {
+            llama_batch_free(verify_batch);
+            verify_batch_owned = false;
+        }
+        llama_sampler_free(greedy);
+        draft_entry->kv_tokens.clear();
+        model->draft_pool->ReleaseContext(std::move(draft_entry));
+        model->context_pool->ReleaseContext(std::move(context_entry));
+    };
+
+    try {
+        std::vector<llama_token> tokens = TokenizeWithCache(vocab, prompt, true);
+        if (tokens.empty()) {
+            release_all();
+            return "Error: Failed to tokenize prompt";
+        }
+        int n_tokens = (int)tokens.size();
+
+        // The draft shares no KV with the target, so each context is primed
+        // on the prompt independently. The prompt tokens come from the target
+        // vocabulary; LoadModel guarantees the draft vocabulary matches.
+        llama_kv_self_clear(tgt_ctx);
+        llama_kv_self_clear(dft_ctx);
+        context_entry->kv_tokens.clear();
+
+        llama_batch prompt_batch = llama_batch_get_one(tokens.data(), tokens.size());
+        if (llama_decode(tgt_ctx, prompt_batch) != 0) {
+            release_all();
+            return "Error: Failed to process prompt";
+        }
+        prompt_batch = llama_batch_get_one(tokens.data(), tokens.size());
+        if (llama_decode(dft_ctx, prompt_batch) != 0) {
+            release_all();
+            return "Error: Failed to process prompt on draft model";
+        }
+
+        latency.prefill.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count());
+
+        context_entry->kv_tokens = tokens;
+        int n_past = n_tokens;  // tokens resident in both KV caches
+
+        const int draft_k = model->config.draft_n_tokens > 0 ? model->config.draft_n_tokens : 5;
+        verify_batch = llama_batch_init(draft_k, 0, 1);
+        verify_batch_owned = true;
+
+        std::string result;
+        int tokens_generated = 0;
+        bool done = false;
+
+        // First token comes straight from the prompt logits; it is emitted
+        // but not yet decoded into either KV cache.
+        llama_token cur = llama_sampler_sample(greedy, tgt_ctx, -1);
+        if (llama_vocab_is_eog(vocab, cur)) {
+            done = true;
+        } else {
+            char piece[256];
+            int n = llama_token_to_piece(vocab, cur, piece, sizeof(piece), 0, true);
+            if (n > 0) {
+                result.append(piece, n);
+            }
+            tokens_generated++;
+            latency.ttft.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_time).count());
+        }
+
+        while (!done && tokens_generated < params.max_tokens) {
+            // Draft phase: catch the draft up on `cur`, then let it run ahead
+            // greedily for up to draft_k tokens.
+            std::vector<llama_token> proposals;
+            llama_token dft_last = cur;
+            for (int i = 0; i < draft_k; ++i) {
+                llama_batch dft_batch = llama_batch_get_one(&dft_last, 1);
+                if (llama_decode(dft_ctx, dft_batch) != 0) {
+                    release_all();
+                    return "Error: Draft decode failed";
+                }
+                llama_token proposed = llama_sampler_sample(greedy, dft_ctx, -1);
+                proposals.push_back(proposed);
+                if (llama_vocab_is_eog(vocab, proposed)) {
+                    break;
+                }
+                dft_last = proposed;
+            }
+
+            // Verify phase: decode [cur, p0 .. p(m-2)] on the target with
+            // logits requested for every position. Row i then holds the
+            // target's prediction for the token after batch entry i, which is
+            // exactly what proposals[i] claims to be.
+            int m = (int)proposals.size();
+            verify_batch.n_tokens = m;
+            for (int i = 0; i < m; ++i) {
+                verify_batch.token[i] = (i == 0) ? cur : proposals[i - 1];
+                verify_batch.pos[i] = n_past + i;
+                verify_batch.n_seq_id[i] = 1;
+                verify_batch.seq_id[i][0] = 0;
+                verify_batch.logits[i] = true;
+            }
+            if (llama_decode(tgt_ctx, verify_batch) != 0) {
+                release_all();
+                return "Error: Failed to decode tokens";
+            }
+
+            int accepted = 0;  // batch entries confirmed resident in target KV
+            for (int i = 0; i < m; ++i) {
+                llama_token next = llama_sampler_sample(greedy, tgt_ctx, i);
+                if (llama_vocab_is_eog(vocab, next)) {
+                    accepted = i + 1;
+                    done = true;
+                    break;
+                }
+
+                char piece[256];
+                int n = llama_token_to_piece(vocab, next, piece, sizeof(piece), 0, true);
+                if (n > 0) {
+                    result.append(piece, n);
+                }
+                tokens_generated++;
+
+                if (next != proposals[i]) {
+                    // The draft diverged; keep the verified prefix and restart
+                    // drafting from the target's own token.
+                    accepted = i + 1;
+                    cur = next;
+                    break;
+                }
+                accepted = i + 1;
+                cur = next;
+                if (tokens_generated >= params.max_tokens) {
+                    done = true;
+                    break;
+                }
+            }
+
+            // Roll both KV caches back to the verified prefix. The target
+            // holds all m batch entries, the draft holds the same stream, and
+            // `cur` stays undecoded for the next round.
+            if (accepted < m) {
+                llama_kv_self_seq_rm(tgt_ctx, 0, n_past + accepted, -1);
+            }
+            for (int i = 0; i < accepted; ++i) {
+                context_entry->kv_tokens.push_back(verify_batch.token[i]);
+            }
+            n_past += accepted;
+            llama_kv_self_seq_rm(dft_ctx, 0, n_past, -1);
+        }
+
+        auto end_time = std::chrono::steady_clock::now();
+        auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        metrics_.total_generation_time_ms += duration_ms;
+        metrics_.total_tokens_generated += tokens_generated;
+        latency.e2e.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+
+        release_all();
+        return result;
+
+    } catch (const std::exception& e) {
+        context_entry->kv_tokens.clear();
+        release_all();
+        std::cerr << "Speculative generation error: " << e.what() << std::endl;
+        return "Error: " + std::string(e.what());
+    }
+}
+
+// FNV-1a over one chat message, chained so hashing messages [0..k) in order
+// yields a prefix hash for any k.
+static uint64_t HashChatMessage(uint64_t h, const ChatMessage& message) {
+    auto mix = [&h](const std::string& s) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xff;
+        h *= 1099511628211ULL;
+    };
+    mix(message.role);
+    mix(message.content);
+    return h;
+}
+
+std::string SimpleModelManager::ChatCompletion(const std::string& model_name,
+                                              const std::vector<ChatMessage>& messages,
                                               const GenerationParams& params) {
-    
+    auto model = GetModel(model_name);
+    const char* tmpl = (model && model->model) ? llama_model_chat_template(model->model, nullptr) : nullptr;
+
+    // Formats messages [begin, end) through the model's template into `out`,
+    // reusing one growable buffer per thread between requests.
+    auto apply_template = [&](size_t begin, size_t end, bool add_assistant, std::string& out) -> bool {
+        thread_local std::vector<char> arena;
+
+        std::vector<llama_chat_message> chat;
+        chat.reserve(end - begin);
+        size_t needed = 64;
+        for (size_t i = begin; i < end; ++i) {
+            chat.push_back({messages[i].role.c_str(), messages[i].content.c_str()});
+            needed += messages[i].role.size() + messages[i].content.size() + 32;
+        }
+        if (arena.size() < needed) arena.resize(needed);
+
+        int32_t n = llama_chat_apply_template(tmpl, chat.data(), chat.size(), add_assistant,
+                                              arena.data(), (int32_t)arena.size());
+        if (n > (int32_t)arena.size()) {
+            arena.resize(n);
+            n = llama_chat_apply_template(tmpl, chat.data(), chat.size(), add_assistant,
+                                          arena.data(), (int32_t)arena.size());
+        }
+        if (n < 0) return false;
+        out.assign(arena.data(), n);
+        return true;
+    };
+
+    if (tmpl) {
+        // Prefix hashes: prefix_hash[k] covers messages [0, k).
+        std::vector<uint64_t> prefix_hash(messages.size() + 1);
+        prefix_hash[0] = 1469598103934665603ULL;
+        for (size_t i = 0; i < messages.size(); ++i) {
+            prefix_hash[i + 1] = HashChatMessage(prefix_hash[i], messages[i]);
+        }
+
+        // Many templates are stateful - BOS emitted only for the first
+        // message, system prompts folded into the following user turn - and
+        // render a split history differently from the whole conversation.
+        // Verify once per model that a split render reproduces the whole
+        // render before trusting the cache; otherwise leave it disabled.
+        int splittable = 0;
+        {
+            std::lock_guard<std::mutex> lock(chat_prefix_mutex_);
+            auto it = chat_prefix_cache_.find(model_name);
+            if (it != chat_prefix_cache_.end()) {
+                splittable = it->second.splittable;
+            }
+        }
+        if (splittable == 0 && messages.size() >= 2) {
+            std::string whole, head, tail;
+            if (apply_template(0, messages.size(), false, whole) &&
+                apply_template(0, 1, false, head) &&
+                apply_template(1, messages.size(), false, tail)) {
+                splittable = (whole == head + tail) ? 1 : -1;
+                std::lock_guard<std::mutex> lock(chat_prefix_mutex_);
+                chat_prefix_cache_[model_name].splittable = splittable;
+            }
+        }
+
+        std::string cached_prefix;
+        size_t cached_count = 0;
+        if (splittable == 1) {
+            std::lock_guard<std::mutex> lock(chat_prefix_mutex_);
+            auto it = chat_prefix_cache_.find(model_name);
+            if (it != chat_prefix_cache_.end() &&
+                it->second.message_count > 0 &&
+                it->second.message_count < messages.size() &&
+                it->second.hash == prefix_hash[it->second.message_count]) {
+                cached_count = it->second.message_count;
+                cached_prefix = it->second.formatted;
+            }
+        }
+
+        std::string suffix;
+        if (apply_template(cached_count, messages.size(), true, suffix)) {
+            // Remember this turn's full history (without the assistant cue)
+            // so the next turn only formats its new messages.
+            std::string suffix_plain;
+            if (splittable == 1 &&
+                apply_template(cached_count, messages.size(), false, suffix_plain)) {
+                std::lock_guard<std::mutex> lock(chat_prefix_mutex_);
+                auto& entry = chat_prefix_cache_[model_name];
+                entry.hash = prefix_hash[messages.size()];
+                entry.message_count = messages.size();
+                entry.formatted = cached_prefix + suffix_plain;
+            }
+
+            std::string prompt;
+            prompt.reserve(cached_prefix.size() + suffix.size());
+            prompt.append(cached_prefix);
+            prompt.append(suffix);
+            return Generate(model_name, prompt, params);
+        }
+        // Template application failed (unsupported template string); fall
+        // through to the plain role-prefixed format.
+    }
+
+    // No GGUF template: single-pass assembly, sized up front so the loop
+    // never reallocates.
+    static const std::string kAssistantCue = "Assistant: ";
+    size_t total = kAssistantCue.size();
+    for (const auto& message : messages) {
+        total += message.content.size() + 12;
+    }
     std::string prompt;
+    prompt.reserve(total);
     for (const auto& message : messages) {
         if (message.role == "system") {
-            prompt += "System: " + message.content + "\n";
+            prompt += "System: ";
         } else if (message.role == "user") {
-            prompt += "User: " + message.content + "\n";
+            prompt += "User: ";
         } else if (message.role == "assistant") {
-            prompt += "Assistant: " + message.content + "\n";
+            prompt += kAssistantCue;
+        } else {
+            continue;
         }
+        prompt += message.content;
+        prompt += '\n';
     }
-    prompt += "Assistant: ";
-    
-    
+    prompt += kAssistantCue;
+
     return Generate(model_name, prompt, params);
 }
 
@@ -776,227 +1771,472 @@ std::vector<float> SimpleModelManager::GetEmbeddings(const std::string& model_na
     }
 }
 
-std::vector<std::pair<std::string, int>> SimpleModelManager::GetGPUInfo() {
-    std::vector<std::pair<std::string, int>> gpu_info;
-    
+std::vector<std::vector<float>> SimpleModelManager::GetEmbeddingsBatch(const std::string& model_name,
+                                                                       const std::vector<std::string>& texts) {
+    std::vector<std::vector<float>> results(texts.size());
+    if (texts.empty()) {
+        return results;
+    }
+
+    auto model = GetModel(model_name);
+    if (!model) {
+        std::cerr << "Model not found: " << model_name << std::endl;
+        return results;
+    }
+
+    auto context_entry = model->context_pool->AcquireContext();
+    if (!context_entry) {
+        std::cerr << "No available context for model: " << model_name << std::endl;
+        return results;
+    }
+
     try {
-        
-        bool vulkan_available = false;
-        bool cuda_available = false;
-        
-        
-        #ifdef GGML_USE_VULKAN
-        vulkan_available = true;
-        #endif
-        
-        
-        #ifdef GGML_USE_CUDA
-        cuda_available = true;
-        #endif
-        
-        if (vulkan_available) {
-            gpu_info.push_back({"Vulkan GPU", 1});
+        const llama_vocab* vocab = llama_model_get_vocab(model->model);
+        int32_t n_embd = llama_model_n_embd(model->model);
+        const size_t max_batch_tokens = model->config.n_batch > 0 ? (size_t)model->config.n_batch : 512;
+        const size_t max_batch_seqs = model->config.n_seq_max > 0 ? (size_t)model->config.n_seq_max : 1;
+
+
+        std::vector<std::vector<llama_token>> row_tokens(texts.size());
+        for (size_t i = 0; i < texts.size(); ++i) {
+            const std::string& text = texts[i];
+            std::vector<llama_token> tokens(text.length() + 100);
+            int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(),
+                                        tokens.data(), tokens.size(), true, false);
+            if (n_tokens < 0) {
+                tokens.resize(-n_tokens);
+                n_tokens = llama_tokenize(vocab, text.c_str(), text.length(),
+                                        tokens.data(), tokens.size(), true, false);
+            }
+            if (n_tokens <= 0) {
+                std::cerr << "Failed to tokenize text for embeddings (row " << i << ")" << std::endl;
+                continue;
+            }
+            tokens.resize(n_tokens);
+            row_tokens[i] = std::move(tokens);
         }
-        if (cuda_available) {
-            gpu_info.push_back({"CUDA GPU", 1});
+
+        enum llama_pooling_type ptype = llama_pooling_type(context_entry->context);
+
+        // Pack rows into multi-sequence batches bounded by the context's token
+        // budget and sequence limit, so one llama_decode covers many rows
+        // instead of one decode per row.
+        size_t row = 0;
+        while (row < texts.size()) {
+
+            while (row < texts.size() && row_tokens[row].empty()) {
+                row++;
+            }
+            if (row >= texts.size()) break;
+
+            size_t first = row;
+            size_t batch_tokens = row_tokens[row].size();
+            row++;
+            while (row < texts.size() &&
+                   !row_tokens[row].empty() &&
+                   (row - first) < max_batch_seqs &&
+                   batch_tokens + row_tokens[row].size() <= max_batch_tokens) {
+                batch_tokens += row_tokens[row].size();
+                row++;
+            }
+
+            llama_batch batch = llama_batch_init(batch_tokens, 0, row - first);
+            batch.n_tokens = 0;
+            // Batch index of each row's last token - the only position per
+            // sequence with an output requested, needed for pooling NONE.
+            std::vector<int32_t> last_token_idx(row - first);
+            for (size_t s = first; s < row; ++s) {
+                llama_seq_id seq = (llama_seq_id)(s - first);
+                const auto& tokens = row_tokens[s];
+                for (size_t t = 0; t < tokens.size(); ++t) {
+                    int32_t idx = batch.n_tokens++;
+                    batch.token[idx] = tokens[t];
+                    batch.pos[idx] = (llama_pos)t;
+                    batch.n_seq_id[idx] = 1;
+                    batch.seq_id[idx][0] = seq;
+                    batch.logits[idx] = (t == tokens.size() - 1);
+                    if (batch.logits[idx]) {
+                        last_token_idx[s - first] = idx;
+                    }
+                }
+            }
+
+            // Each packed batch restarts sequence positions at zero.
+            llama_kv_self_clear(context_entry->context);
+            context_entry->kv_tokens.clear();
+
+            if (llama_decode(context_entry->context, batch) != 0) {
+                std::cerr << "Failed to process batched tokens for embeddings (rows "
+                          << first << "-" << (row - 1) << ")" << std::endl;
+                llama_batch_free(batch);
+                continue;
+            }
+
+            for (size_t s = first; s < row; ++s) {
+                llama_seq_id seq = (llama_seq_id)(s - first);
+                const float* embeddings = nullptr;
+                if (ptype != LLAMA_POOLING_TYPE_NONE) {
+                    embeddings = llama_get_embeddings_seq(context_entry->context, seq);
+                }
+                if (!embeddings) {
+                    // Pooling NONE: read the embedding at the row's last-token
+                    // batch index, the position its output was requested at.
+                    embeddings = llama_get_embeddings_ith(context_entry->context, last_token_idx[s - first]);
+                }
+                if (embeddings) {
+                    results[s].assign(embeddings, embeddings + n_embd);
+                } else {
+                    std::cerr << "Failed to get embeddings for row " << s << std::endl;
+                }
+            }
+
+            llama_batch_free(batch);
         }
-        if (!vulkan_available && !cuda_available) {
-            gpu_info.push_back({"CPU Only", 0});
+
+        model->context_pool->ReleaseContext(std::move(context_entry));
+        return results;
+
+    } catch (const std::exception& e) {
+        model->context_pool->ReleaseContext(std::move(context_entry));
+        std::cerr << "Batched embeddings error: " << e.what() << std::endl;
+        return results;
+    }
+}
+
+std::vector<GPUDeviceInfo> SimpleModelManager::GetGPUInfo() {
+    // Ask the loaded ggml backends what actually exists instead of reporting
+    // compile-time defines: a CUDA build on a 4-GPU node gets four entries,
+    // each with its current free/total VRAM.
+    std::vector<GPUDeviceInfo> devices;
+
+    try {
+        size_t count = ggml_backend_dev_count();
+        for (size_t i = 0; i < count; ++i) {
+            ggml_backend_dev_t dev = ggml_backend_dev_get(i);
+            if (!dev) continue;
+
+            GPUDeviceInfo info;
+            info.index = static_cast<int>(i);
+            const char* name = ggml_backend_dev_name(dev);
+            const char* desc = ggml_backend_dev_description(dev);
+            info.name = name ? name : "";
+            info.description = desc ? desc : "";
+            ggml_backend_dev_memory(dev, &info.memory_free, &info.memory_total);
+            info.is_gpu = ggml_backend_dev_type(dev) == GGML_BACKEND_DEVICE_TYPE_GPU;
+            devices.push_back(std::move(info));
         }
-        
-        return gpu_info;
+        return devices;
     } catch (const std::exception& e) {
         std::cerr << "Failed to get GPU info: " << e.what() << std::endl;
-        return {{"CPU Only", 0}};
+        return devices;
+    }
+}
+
+
+TokenRing::~TokenRing() {
+    // Drain slots the consumer never read so spilled pieces do not leak.
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        Slot& slot = slots_[tail & (kCapacity - 1)];
+        delete[] slot.heap_text;
+        slot.heap_text = nullptr;
     }
 }
 
+bool TokenRing::Push(const StreamToken& token) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= kCapacity) {
+        return false;  // full; caller decides whether to wait
+    }
+
+    Slot& slot = slots_[head & (kCapacity - 1)];
+    slot.length = static_cast<uint32_t>(token.text.size());
+    if (token.text.size() <= kInlineSize) {
+        std::memcpy(slot.inline_text, token.text.data(), token.text.size());
+        slot.heap_text = nullptr;
+    } else {
+        slot.heap_text = new char[token.text.size()];
+        std::memcpy(slot.heap_text, token.text.data(), token.text.size());
+    }
+    slot.probability = token.probability;
+    slot.token_id = token.token_id;
+    slot.is_final = token.is_final;
+
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool TokenRing::Pop(StreamToken& token) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) {
+        return false;  // empty
+    }
+
+    Slot& slot = slots_[tail & (kCapacity - 1)];
+    const char* text = slot.heap_text ? slot.heap_text : slot.inline_text;
+    token.text.assign(text, slot.length);
+    token.is_final = slot.is_final;
+    token.probability = slot.probability;
+    token.token_id = slot.token_id;
+    if (slot.heap_text) {
+        delete[] slot.heap_text;
+        slot.heap_text = nullptr;
+    }
+
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool TokenRing::Empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
 
 StreamingSession::StreamingSession(const std::string& id, const std::string& model, const std::string& prompt_text, const GenerationParams& gen_params)
     : session_id(id), model_name(model), prompt(prompt_text), params(gen_params) {}
 
 StreamingSession::~StreamingSession() {
     Stop();
+    ReleaseResources();
 }
 
-void StreamingSession::StartGeneration() {
-    generation_thread = std::thread([this]() {
-        try {
-            auto& manager = SimpleModelManager::GetInstance();
-            auto model = manager.GetModel(model_name);
-            if (!model) {
-                error = true;
-                error_message = "Model not found: " + model_name;
-                finished = true;
-                queue_cv.notify_all();
-                return;
+// The generation state machine. Each call runs on one executor worker;
+// slices of different sessions interleave on the same fixed set of workers.
+bool StreamingSession::RunSlice() {
+    try {
+        auto& manager = SimpleModelManager::GetInstance();
+
+        if (finished.load(std::memory_order_acquire)) {
+            ReleaseResources();
+            return false;
+        }
+
+        if (!started_) {
+            started_ = true;
+            start_time_ = std::chrono::steady_clock::now();
+        }
+
+        // Flush a final marker that did not fit into the ring last slice.
+        if (final_pending_) {
+            if (!token_ring.Push(StreamToken{"", true, 0.0f, -1})) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+                return true;
             }
+            final_pending_ = false;
+            ReleaseResources();
+            finished = true;
+            return false;
+        }
 
-            
-            auto context_entry = model->context_pool->AcquireContext();
-            if (!context_entry) {
-                error = true;
-                error_message = "Failed to get context for streaming";
-                finished = true;
-                queue_cv.notify_all();
-                return;
+        if (!prompt_evaluated_) {
+            if (!model_ref_) {
+                model_ref_ = manager.GetModel(model_name);
+                if (!model_ref_) {
+                    FailSession("Model not found: " + model_name);
+                    return false;
+                }
+            }
+
+            if (!context_entry_) {
+                context_entry_ = model_ref_->context_pool->AcquireContext();
+                if (!context_entry_) {
+                    // Pool exhausted: yield the worker and retry later
+                    // instead of parking a thread on the pool.
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    return true;
+                }
             }
 
-            
-            manager.ConfigureSampler(context_entry->sampler, params);
+            manager.ConfigureSampler(context_entry_.get(), params);
 
-            
-            const llama_vocab* vocab = llama_model_get_vocab(model->model);
-            std::vector<llama_token> tokens(prompt.length() + 100);
-            int n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), 
-                                        tokens.data(), tokens.size(), true, true);
-            if (n_tokens < 0) {
-                tokens.resize(-n_tokens);
-                n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), 
-                                        tokens.data(), tokens.size(), true, true);
+            vocab_ = llama_model_get_vocab(model_ref_->model);
+            std::vector<llama_token> tokens = manager.TokenizeWithCache(vocab_, prompt, true);
+            if (tokens.empty()) {
+                FailSession("Failed to tokenize prompt");
+                return false;
             }
-            if (n_tokens <= 0) {
-                error = true;
-                error_message = "Failed to tokenize prompt";
-                model->context_pool->ReleaseContext(std::move(context_entry));
-                finished = true;
-                queue_cv.notify_all();
-                return;
+
+            if (llama_decode(context_entry_->context, llama_batch_get_one(tokens.data(), tokens.size())) != 0) {
+                FailSession("Failed to evaluate prompt");
+                return false;
             }
-            tokens.resize(n_tokens);
-            
-            
-            if (llama_decode(context_entry->context, llama_batch_get_one(tokens.data(), tokens.size())) != 0) {
-                error = true;
-                error_message = "Failed to evaluate prompt";
-                model->context_pool->ReleaseContext(std::move(context_entry));
-                finished = true;
-                queue_cv.notify_all();
-                return;
+
+            manager.GetLatencyMetrics(model_name).prefill.Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start_time_).count());
+
+            prompt_evaluated_ = true;
+            return true;  // yield between prefill and the first decode slice
+        }
+
+        auto& latency = manager.GetLatencyMetrics(model_name);
+        for (int slice = 0; slice < kSliceTokens; ++slice) {
+            if (n_generated_ >= params.max_tokens || finished.load(std::memory_order_acquire)) {
+                final_pending_ = true;
+                return RunSlice();
             }
 
-            
-            int n_generated = 0;
-            
-            while (n_generated < params.max_tokens && !finished.load()) {
-                llama_token token = llama_sampler_sample(context_entry->sampler, context_entry->context, -1);
-                
-                
-                if (llama_vocab_is_eog(vocab, token)) {
-                    break;
-                }
+            llama_token token = llama_sampler_sample(context_entry_->sampler, context_entry_->context, -1);
 
-                
-                char token_str[256];
-                int n_chars = llama_token_to_piece(vocab, token, token_str, sizeof(token_str), 0, true);
-                std::string token_text;
-                if (n_chars > 0) {
-                    token_text = std::string(token_str, n_chars);
-                } else {
-                    token_text = "[UNK]"; 
-                }
-                    
-                
-                float token_probability = 0.0f;
-                try {
-                    
-                    const float* logits = llama_get_logits(context_entry->context);
-                    if (logits) {
-                        int32_t n_vocab = llama_vocab_n_tokens(vocab);
-                        if (token >= 0 && token < n_vocab) {
-                            
-                            float logit_value = logits[token];
-                            token_probability = expf(logit_value); 
-                            
-                            
-                            
-                            if (token_probability > 1.0f) {
-                                token_probability = 1.0f; 
-                            }
-                        }
-                    }
-                } catch (const std::exception& e) {
-                    
-                    token_probability = 0.0f;
-                }
-                
-                
-                {
-                    std::lock_guard<std::mutex> lock(queue_mutex);
-                    token_queue.emplace(StreamToken{
-                        token_text,
-                        false, 
-                        token_probability,
-                        token
-                    });
-                }
-                queue_cv.notify_one();
+            if (llama_vocab_is_eog(vocab_, token)) {
+                final_pending_ = true;
+                return RunSlice();
+            }
 
-                
-                if (llama_decode(context_entry->context, llama_batch_get_one(&token, 1)) != 0) {
-                    error = true;
-                    error_message = "Failed to decode token";
-                    break;
+            char token_str[256];
+            int n_chars = llama_token_to_piece(vocab_, token, token_str, sizeof(token_str), 0, true);
+            std::string token_text;
+            if (n_chars > 0) {
+                token_text = std::string(token_str, n_chars);
+            } else {
+                token_text = "[UNK]";
+            }
+
+            float token_probability = 0.0f;
+            const float* logits = llama_get_logits(context_entry_->context);
+            if (logits) {
+                int32_t n_vocab = llama_vocab_n_tokens(vocab_);
+                if (token >= 0 && token < n_vocab) {
+                    token_probability = expf(logits[token]);
+                    if (token_probability > 1.0f) {
+                        token_probability = 1.0f;
+                    }
                 }
+            }
 
-                n_generated++;
+            if (!token_ring.Push(StreamToken{token_text, false, token_probability, token})) {
+                // Consumer is behind; give the ring time to drain on someone
+                // else's worker time, then resample this same token (the
+                // context has not advanced, so the sample is identical).
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+                return true;
             }
 
-            
-            {
-                std::lock_guard<std::mutex> lock(queue_mutex);
-                token_queue.emplace(StreamToken{"", true, 0.0f, -1}); 
+            // TTFT for streaming is when the first token becomes visible
+            // to the consumer, i.e. right after the first push.
+            if (n_generated_ == 0) {
+                latency.ttft.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start_time_).count());
             }
-            queue_cv.notify_one();
 
-            
-            model->context_pool->ReleaseContext(std::move(context_entry));
-            finished = true;
+            auto decode_start = std::chrono::steady_clock::now();
+            if (llama_decode(context_entry_->context, llama_batch_get_one(&token, 1)) != 0) {
+                error = true;
+                error_message = "Failed to decode token";
+                final_pending_ = true;
+                return RunSlice();
+            }
+            latency.decode.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - decode_start).count());
 
-        } catch (const std::exception& e) {
-            error = true;
-            error_message = e.what();
-            finished = true;
-            queue_cv.notify_all();
+            n_generated_++;
         }
-    });
+
+        return true;
+
+    } catch (const std::exception& e) {
+        FailSession(e.what());
+        return false;
+    }
+}
+
+void StreamingSession::FailSession(const std::string& message) {
+    error = true;
+    error_message = message;
+    ReleaseResources();
+    finished = true;
+}
+
+void StreamingSession::ReleaseResources() {
+    if (context_entry_ && model_ref_ && model_ref_->context_pool) {
+        model_ref_->context_pool->ReleaseContext(std::move(context_entry_));
+    }
+    context_entry_.reset();
+    model_ref_.reset();
+    vocab_ = nullptr;
 }
 
 bool llama_capi::StreamingSession::GetNextToken(llama_capi::StreamToken& token) {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-    
-    
-    queue_cv.wait(lock, [this] { return !token_queue.empty() || finished.load(); });
-    
-    if (!token_queue.empty()) {
-        token = token_queue.front();
-        token_queue.pop();
-        return true;
+    // Poll the lock-free ring: yield first (the producer usually publishes the
+    // next token within one decode step), then back off to a short sleep.
+    for (;;) {
+        if (token_ring.Pop(token)) {
+            return true;
+        }
+        if (finished.load(std::memory_order_acquire)) {
+            // One more pop closes the race with a producer that pushed its
+            // final token just before setting `finished`.
+            return token_ring.Pop(token);
+        }
+        std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
-    
-    return false; 
+}
+
+bool llama_capi::StreamingSession::TryGetNextToken(llama_capi::StreamToken& token) {
+    return token_ring.Pop(token);
 }
 
 void llama_capi::StreamingSession::Stop() {
+    // The executor worker that next runs this session observes `finished`
+    // and releases its context; resources still held at destruction time
+    // are cleaned up by the destructor.
     finished = true;
-    queue_cv.notify_all();
-    if (generation_thread.joinable()) {
-        generation_thread.join();
+}
+
+
+// Executor workers loop over the ready queue; a session that still has work
+// after a slice goes to the back of the queue, so N sessions interleave
+// fairly on a fixed number of threads.
+void llama_capi::SimpleModelManager::StreamWorkerLoop() {
+    for (;;) {
+        std::shared_ptr<StreamingSession> session;
+        {
+            std::unique_lock<std::mutex> lock(stream_queue_mutex_);
+            stream_queue_cv_.wait(lock, [this]() {
+                return should_stop_stream_workers_.load() || !stream_ready_.empty();
+            });
+            if (should_stop_stream_workers_.load()) {
+                return;
+            }
+            session = std::move(stream_ready_.front());
+            stream_ready_.pop_front();
+        }
+
+        if (session->RunSlice()) {
+            std::lock_guard<std::mutex> lock(stream_queue_mutex_);
+            stream_ready_.push_back(std::move(session));
+            stream_queue_cv_.notify_one();
+        }
     }
 }
 
+void llama_capi::SimpleModelManager::ScheduleStreamSession(std::shared_ptr<StreamingSession> session) {
+    std::lock_guard<std::mutex> lock(stream_queue_mutex_);
+    if (!stream_workers_started_) {
+        // Lazy start: sized to the context pool cap, since that is the most
+        // sessions that can decode concurrently anyway.
+        should_stop_stream_workers_ = false;
+        size_t worker_count = max_context_pool_size_ > 0 ? max_context_pool_size_ : 4;
+        for (size_t i = 0; i < worker_count; ++i) {
+            stream_workers_.emplace_back(&SimpleModelManager::StreamWorkerLoop, this);
+        }
+        stream_workers_started_ = true;
+    }
+    stream_ready_.push_back(std::move(session));
+    stream_queue_cv_.notify_one();
+}
 
 std::string llama_capi::SimpleModelManager::StartStreamingSession(const std::string& model_name, const std::string& prompt, const llama_capi::GenerationParams& params) {
-    std::lock_guard<std::mutex> lock(streaming_mutex_);
-    
-    
     std::string session_id = "stream_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
-    
-    
-    auto session = std::make_shared<llama_capi::StreamingSession>(session_id, model_name, prompt, params);
-    session->StartGeneration();
 
-    streaming_sessions_[session_id] = std::move(session);
+    auto session = std::make_shared<llama_capi::StreamingSession>(session_id, model_name, prompt, params);
+    {
+        std::lock_guard<std::mutex> lock(streaming_mutex_);
+        streaming_sessions_[session_id] = session;
+    }
+    ScheduleStreamSession(std::move(session));
     return session_id;
 }
 
@@ -1008,11 +2248,22 @@ bool llama_capi::SimpleModelManager::GetNextStreamToken(const std::string& sessi
         if (it == streaming_sessions_.end()) return false;
         session = it->second;  // copy shared_ptr, bumps refcount
     }
-    // Call outside the lock — GetNextToken blocks on a condition variable.
+    // Call outside the lock — GetNextToken blocks polling the token ring.
     // The shared_ptr keeps the session alive even if CleanupExpiredSessions erases it.
     return session->GetNextToken(token);
 }
 
+bool llama_capi::SimpleModelManager::TryGetNextStreamToken(const std::string& session_id, llama_capi::StreamToken& token) {
+    std::shared_ptr<StreamingSession> session;
+    {
+        std::lock_guard<std::mutex> lock(streaming_mutex_);
+        auto it = streaming_sessions_.find(session_id);
+        if (it == streaming_sessions_.end()) return false;
+        session = it->second;
+    }
+    return session->TryGetNextToken(token);
+}
+
 void llama_capi::SimpleModelManager::StopStreamingSession(const std::string& session_id) {
     std::lock_guard<std::mutex> lock(streaming_mutex_);
     
@@ -1039,32 +2290,372 @@ void llama_capi::SimpleModelManager::CleanupExpiredSessions() {
 
 std::string llama_capi::SimpleModelManager::SubmitBatchRequest(const std::string& model_name, const std::string& prompt, const llama_capi::GenerationParams& params) {
     std::lock_guard<std::mutex> lock(batch_mutex_);
-    
-    
+
+
     std::string request_id = "batch_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
-    
+
     llama_capi::BatchRequest request;
     request.request_id = request_id;
     request.model_name = model_name;
     request.prompt = prompt;
     request.params = params;
     request.submitted_at = std::chrono::steady_clock::now();
-    
+
     batch_queue_.push(std::move(request));
+
+
+    if (!batch_processor_.joinable()) {
+        should_stop_batch_ = false;
+        batch_processor_ = std::thread(&SimpleModelManager::BatchProcessingTask, this);
+    }
+
     batch_cv_.notify_one();
-    
+
     return request_id;
 }
 
+void llama_capi::SimpleModelManager::BatchProcessingTask() {
+    while (!should_stop_batch_) {
+        std::string model_name;
+        std::vector<BatchRequest> pending;
+        {
+            std::unique_lock<std::mutex> lock(batch_mutex_);
+            batch_cv_.wait(lock, [this] { return should_stop_batch_.load() || !batch_queue_.empty(); });
+            if (should_stop_batch_) break;
+
+            // Drain every queued request for the model at the head of the
+            // queue so one context can serve them as a continuous batch;
+            // requests for other models stay queued for the next round.
+            model_name = batch_queue_.front().model_name;
+            std::queue<BatchRequest> rest;
+            while (!batch_queue_.empty()) {
+                BatchRequest request = std::move(batch_queue_.front());
+                batch_queue_.pop();
+                if (request.model_name == model_name) {
+                    pending.push_back(std::move(request));
+                } else {
+                    rest.push(std::move(request));
+                }
+            }
+            batch_queue_ = std::move(rest);
+        }
+
+        ProcessBatchGroup(model_name, pending);
+    }
+}
+
+static size_t BatchResultBytes(const llama_capi::BatchResult& result) {
+    return sizeof(llama_capi::BatchResult) + result.request_id.size() +
+           result.response.size() + result.error_message.size();
+}
+
+void llama_capi::SimpleModelManager::StoreBatchResult(const BatchRequest& request, std::string response, bool success, const std::string& error_message) {
+    BatchResult result;
+    result.request_id = request.request_id;
+    result.response = std::move(response);
+    result.success = success;
+    result.error_message = error_message;
+    result.completed_at = std::chrono::steady_clock::now();
+    result.processing_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        result.completed_at - request.submitted_at).count();
+
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    result.sequence = ++batch_result_seq_;
+    batch_results_bytes_ += BatchResultBytes(result);
+    batch_result_order_.push_back(request.request_id);
+    batch_results_[request.request_id] = std::move(result);
+    EvictBatchResults();
+}
+
+// Drops results whose TTL has passed, then keeps dropping oldest-first until
+// the store fits its byte budget. List nodes whose id was already retrieved
+// (and so is absent from the map) are discarded as they are encountered.
+void llama_capi::SimpleModelManager::EvictBatchResults() {
+    auto now = std::chrono::steady_clock::now();
+    while (!batch_result_order_.empty()) {
+        auto it = batch_results_.find(batch_result_order_.front());
+        if (it == batch_results_.end()) {
+            batch_result_order_.pop_front();
+            continue;
+        }
+        bool expired = (now - it->second.completed_at) > kBatchResultTTL;
+        if (!expired && batch_results_bytes_ <= kBatchResultsMaxBytes) {
+            break;
+        }
+        batch_results_bytes_ -= BatchResultBytes(it->second);
+        batch_results_.erase(it);
+        batch_result_order_.pop_front();
+    }
+}
+
+void llama_capi::SimpleModelManager::ProcessBatchGroup(const std::string& model_name, std::vector<BatchRequest>& requests) {
+    auto model = GetModel(model_name);
+    if (!model) {
+        for (const auto& request : requests) {
+            StoreBatchResult(request, "", false, "Model not found: " + model_name);
+        }
+        return;
+    }
+
+    auto context_entry = model->context_pool->AcquireContext();
+    if (!context_entry) {
+        // No context to share: fall back to the serial path rather than fail.
+        for (const auto& request : requests) {
+            std::string response = Generate(model_name, request.prompt, request.params);
+            bool ok = response.compare(0, 7, "Error: ") != 0;
+            StoreBatchResult(request, std::move(response), ok, ok ? "" : "Generation failed");
+        }
+        return;
+    }
+
+    const llama_vocab* vocab = llama_model_get_vocab(model->model);
+    const int max_seqs = model->config.n_seq_max > 0 ? model->config.n_seq_max : 1;
+    const int max_batch_tokens = model->config.n_batch > 0 ? model->config.n_batch : 512;
+
+    // Per-sequence decode state. Each in-flight request owns one KV sequence
+    // and one sampler chain; finished sequences free their slot so queued
+    // requests are admitted mid-flight (continuous batching).
+    struct ActiveSeq {
+        size_t request_idx;
+        llama_seq_id seq_id;
+        std::vector<llama_token> prompt_tokens;
+        llama_token last_token;
+        int n_past;
+        int n_generated;
+        bool prefilled;
+        std::string output;
+        llama_sampler* sampler;
+        std::chrono::steady_clock::time_point start_time;
+    };
+
+    // Mirrors the stages ConfigureSampler compiles, so a request samples the
+    // same whether it runs batched here or through the serial Generate
+    // fallbacks below (oversized prompt, no free context).
+    auto build_sampler = [](const GenerationParams& params) -> llama_sampler* {
+        llama_sampler* sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
+        if (!sampler) return nullptr;
+        if (params.temperature <= 0.0f) {
+            llama_sampler_chain_add(sampler, llama_sampler_init_greedy());
+        } else {
+            if (params.repeat_penalty != 1.0f) {
+                llama_sampler_chain_add(sampler, llama_sampler_init_penalties(
+                    params.repeat_last_n, params.repeat_penalty, 0.0f, 0.0f));
+            }
+            llama_sampler_chain_add(sampler, llama_sampler_init_top_k(params.top_k));
+            llama_sampler_chain_add(sampler, llama_sampler_init_top_p(params.top_p, 1));
+            llama_sampler_chain_add(sampler, llama_sampler_init_temp(params.temperature));
+            llama_sampler_chain_add(sampler, llama_sampler_init_dist(params.seed >= 0 ? (uint32_t)params.seed : 12345));
+        }
+        return sampler;
+    };
+
+    llama_kv_self_clear(context_entry->context);
+    context_entry->kv_tokens.clear();
+
+    std::vector<ActiveSeq> active;
+    std::vector<llama_seq_id> free_seq_ids;
+    for (int i = max_seqs - 1; i >= 0; --i) {
+        free_seq_ids.push_back((llama_seq_id)i);
+    }
+
+    size_t next_request = 0;
+    bool decode_failed = false;
+
+    while ((next_request < requests.size() || !active.empty()) && !decode_failed && !should_stop_batch_) {
+        // Admit queued requests into free sequence slots.
+        while (!free_seq_ids.empty() && next_request < requests.size()) {
+            const BatchRequest& request = requests[next_request];
+
+            std::vector<llama_token> tokens(request.prompt.length() + 100);
+            int n_tokens = llama_tokenize(vocab, request.prompt.c_str(), request.prompt.length(),
+                                        tokens.data(), tokens.size(), true, true);
+            if (n_tokens < 0) {
+                tokens.resize(-n_tokens);
+                n_tokens = llama_tokenize(vocab, request.prompt.c_str(), request.prompt.length(),
+                                        tokens.data(), tokens.size(), true, true);
+            }
+            if (n_tokens <= 0) {
+                StoreBatchResult(request, "", false, "Failed to tokenize prompt");
+                next_request++;
+                continue;
+            }
+            tokens.resize(n_tokens);
+
+            if (n_tokens >= max_batch_tokens) {
+                // Prompt exceeds one decode's token budget; run it through the
+                // single-sequence path instead of blocking the whole batch.
+                std::string response = Generate(model_name, request.prompt, request.params);
+                bool ok = response.compare(0, 7, "Error: ") != 0;
+                StoreBatchResult(request, std::move(response), ok, ok ? "" : "Generation failed");
+                next_request++;
+                continue;
+            }
+
+            llama_sampler* sampler = build_sampler(request.params);
+            if (!sampler) {
+                StoreBatchResult(request, "", false, "Failed to create sampler");
+                next_request++;
+                continue;
+            }
+
+            ActiveSeq seq;
+            seq.request_idx = next_request;
+            seq.seq_id = free_seq_ids.back();
+            free_seq_ids.pop_back();
+            seq.prompt_tokens = std::move(tokens);
+            seq.last_token = 0;
+            seq.n_past = 0;
+            seq.n_generated = 0;
+            seq.prefilled = false;
+            seq.sampler = sampler;
+            seq.start_time = std::chrono::steady_clock::now();
+            active.push_back(std::move(seq));
+            next_request++;
+        }
+
+        if (active.empty()) {
+            continue;
+        }
+
+        // One decode step: prefill tokens for newly admitted sequences plus
+        // one continuation token for every running sequence.
+        int step_tokens = 0;
+        std::vector<size_t> step_order;
+        for (size_t i = 0; i < active.size(); ++i) {
+            int needed = active[i].prefilled ? 1 : (int)active[i].prompt_tokens.size();
+            if (step_tokens + needed > max_batch_tokens && !step_order.empty()) {
+                continue;
+            }
+            step_tokens += needed;
+            step_order.push_back(i);
+        }
+
+        llama_batch batch = llama_batch_init(step_tokens, 0, max_seqs);
+        batch.n_tokens = 0;
+        // Batch index of each stepped sequence's last token: that is the only
+        // position with logits=true for the sequence, and the index the
+        // sampler must be given.
+        std::vector<int32_t> step_logit_idx(step_order.size());
+        for (size_t s = 0; s < step_order.size(); ++s) {
+            ActiveSeq& seq = active[step_order[s]];
+            if (!seq.prefilled) {
+                for (size_t t = 0; t < seq.prompt_tokens.size(); ++t) {
+                    int32_t idx = batch.n_tokens++;
+                    batch.token[idx] = seq.prompt_tokens[t];
+                    batch.pos[idx] = (llama_pos)t;
+                    batch.n_seq_id[idx] = 1;
+                    batch.seq_id[idx][0] = seq.seq_id;
+                    batch.logits[idx] = (t == seq.prompt_tokens.size() - 1);
+                    if (batch.logits[idx]) {
+                        step_logit_idx[s] = idx;
+                    }
+                }
+                seq.n_past = (int)seq.prompt_tokens.size();
+            } else {
+                int32_t idx = batch.n_tokens++;
+                batch.token[idx] = seq.last_token;
+                batch.pos[idx] = (llama_pos)seq.n_past;
+                batch.n_seq_id[idx] = 1;
+                batch.seq_id[idx][0] = seq.seq_id;
+                batch.logits[idx] = true;
+                step_logit_idx[s] = idx;
+                seq.n_past++;
+            }
+        }
+
+        if (llama_decode(context_entry->context, batch) != 0) {
+            llama_batch_free(batch);
+            decode_failed = true;
+            break;
+        }
+        llama_batch_free(batch);
+
+        // Sample each stepped sequence at its last token's batch index - the
+        // position that carried logits=true in this decode.
+        std::vector<size_t> finished;
+        for (size_t row = 0; row < step_order.size(); ++row) {
+            ActiveSeq& seq = active[step_order[row]];
+            seq.prefilled = true;
+
+            llama_token token = llama_sampler_sample(seq.sampler, context_entry->context, step_logit_idx[row]);
+            llama_sampler_accept(seq.sampler, token);
+
+            bool done = false;
+            if (llama_vocab_is_eog(vocab, token)) {
+                done = true;
+            } else {
+                char piece[256];
+                int n = llama_token_to_piece(vocab, token, piece, sizeof(piece), 0, true);
+                if (n > 0) {
+                    seq.output.append(piece, n);
+                }
+                seq.n_generated++;
+                seq.last_token = token;
+                if (seq.n_generated >= requests[seq.request_idx].params.max_tokens) {
+                    done = true;
+                }
+            }
+
+            if (done) {
+                finished.push_back(step_order[row]);
+            }
+        }
+
+        // Retire finished sequences (largest index first so erase stays valid)
+        // and recycle their KV range and slot.
+        std::sort(finished.rbegin(), finished.rend());
+        for (size_t idx : finished) {
+            ActiveSeq& seq = active[idx];
+            const BatchRequest& request = requests[seq.request_idx];
+
+            auto end_time = std::chrono::steady_clock::now();
+            auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - seq.start_time).count();
+            metrics_.total_requests++;
+            metrics_.total_generation_time_ms += duration_ms;
+            metrics_.total_tokens_generated += seq.n_generated;
+            GetLatencyMetrics(model_name).e2e.Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(end_time - seq.start_time).count());
+
+            StoreBatchResult(request, std::move(seq.output), true, "");
+
+            llama_kv_self_seq_rm(context_entry->context, seq.seq_id, -1, -1);
+            free_seq_ids.push_back(seq.seq_id);
+            llama_sampler_free(seq.sampler);
+            active.erase(active.begin() + idx);
+        }
+    }
+
+    // Anything still active (decode failure or shutdown) gets an error result.
+    for (ActiveSeq& seq : active) {
+        StoreBatchResult(requests[seq.request_idx],
+                         std::move(seq.output), false,
+                         decode_failed ? "Batch decode failed" : "Batch processing stopped");
+        llama_sampler_free(seq.sampler);
+    }
+    for (size_t i = next_request; i < requests.size() && decode_failed; ++i) {
+        StoreBatchResult(requests[i], "", false, "Batch decode failed");
+    }
+
+    llama_kv_self_clear(context_entry->context);
+    context_entry->kv_tokens.clear();
+    model->context_pool->ReleaseContext(std::move(context_entry));
+}
+
 llama_capi::BatchResult llama_capi::SimpleModelManager::GetBatchResult(const std::string& request_id) {
     std::lock_guard<std::mutex> lock(batch_mutex_);
-    
+
     auto it = batch_results_.find(request_id);
     if (it != batch_results_.end()) {
-        return it->second;
+        // Move out and drop the entry: the response string changes hands
+        // instead of being copied, and retrieved results stop counting
+        // against the store's budget.
+        llama_capi::BatchResult result = std::move(it->second);
+        batch_results_bytes_ -= BatchResultBytes(result);
+        batch_results_.erase(it);
+        return result;
     }
-    
-    
+
+
     llama_capi::BatchResult result;
     result.request_id = request_id;
     result.success = false;
@@ -1072,12 +2663,28 @@ llama_capi::BatchResult llama_capi::SimpleModelManager::GetBatchResult(const std
     return result;
 }
 
-std::vector<llama_capi::BatchResult> llama_capi::SimpleModelManager::GetAllBatchResults() {
+std::vector<llama_capi::BatchResult> llama_capi::SimpleModelManager::GetBatchResultsSince(uint64_t cursor, uint64_t& next_cursor) {
     std::lock_guard<std::mutex> lock(batch_mutex_);
-    
+    next_cursor = batch_result_seq_;
+
+    // Completion order equals sequence order, so matching entries form a
+    // suffix of the order list; everything returned is moved out.
     std::vector<llama_capi::BatchResult> results;
-    for (const auto& pair : batch_results_) {
-        results.push_back(pair.second);
+    auto it = batch_result_order_.begin();
+    while (it != batch_result_order_.end()) {
+        auto found = batch_results_.find(*it);
+        if (found == batch_results_.end()) {
+            it = batch_result_order_.erase(it);
+            continue;
+        }
+        if (found->second.sequence > cursor) {
+            batch_results_bytes_ -= BatchResultBytes(found->second);
+            results.push_back(std::move(found->second));
+            batch_results_.erase(found);
+            it = batch_result_order_.erase(it);
+            continue;
+        }
+        ++it;
     }
     return results;
 }
@@ -1,4 +1,5 @@
 #include "include/ai_functions.h"
+#include "include/trace_ring.h"
 #include "duckdb_extension.h"
 
 #include <stdio.h>
@@ -18,10 +19,15 @@ extern char* cpp_llama_download_model(const char* source, const char* name, cons
 extern char* cpp_llama_load_model(const char* path, const char* config_json);
 extern char* cpp_llama_load_model_for_embeddings(const char* path, const char* config_json);
 extern char* cpp_llama_unload_model(const char* name);
+extern char* cpp_llama_model_load_status(const char* name);
 extern char* cpp_llama_list_loaded(void);
 extern char* cpp_llama_generate(const char* model, const char* prompt, const char* options_json);
+extern char** cpp_llama_generate_batch(const char* model, const char* const* prompts, size_t count, const char* options_json);
 extern char* cpp_llama_chat(const char* model, const char* messages_json, const char* options_json);
 extern char* cpp_llama_embed(const char* model, const char* text);
+extern char** cpp_llama_embed_batch(const char* model, const char* const* texts, size_t count);
+extern float* cpp_llama_embed_raw(const char* model, const char* text, size_t* out_dim);
+extern float** cpp_llama_embed_raw_batch(const char* model, const char* const* texts, size_t count, size_t* out_dim);
 extern char* cpp_llama_batch_process(const char* json_request);
 extern char* cpp_llama_status(void);
 extern char* cpp_llama_model_info(const char* name);
@@ -32,8 +38,40 @@ extern char* cpp_llama_get_context_pool_status(void);
 extern char* cpp_llama_cleanup_contexts(void);
 extern char* cpp_llama_start_streaming(const char* model, const char* prompt, const char* options_json);
 extern char* cpp_llama_get_stream_token(const char* session_id);
+extern char* cpp_llama_try_get_stream_token(const char* session_id);
 extern char* cpp_llama_stop_streaming(const char* session_id);
 extern char* cpp_llama_get_batch_result(const char* request_id);
+extern char* cpp_llama_batch_results_since(uint64_t cursor);
+
+/* Mirror of the definition in ai_backend_bridge.cpp. */
+typedef struct {
+    char* model;
+    char* metric;
+    uint64_t count;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+} cpp_llama_latency_row;
+
+extern cpp_llama_latency_row* cpp_llama_latency_rows(size_t* out_count);
+extern void cpp_llama_free_latency_rows(cpp_llama_latency_row* rows, size_t count);
+
+/* Mirror of the definition in ai_backend_bridge.cpp. */
+struct cpp_llama_gguf_info_t {
+    char* architecture;
+    char* quantization;
+    uint64_t parameter_count;
+    uint64_t context_length;
+    uint64_t embedding_length;
+    uint32_t gguf_version;
+    uint64_t tensor_count;
+    char* error;
+};
+
+extern int cpp_llama_gguf_info(const char* path, struct cpp_llama_gguf_info_t* out);
+extern void cpp_llama_free_gguf_info(struct cpp_llama_gguf_info_t* info);
 
 #ifdef __cplusplus
 }
@@ -184,6 +222,24 @@ void llama_load_model_for_embeddings_function(duckdb_function_info info, duckdb_
     }
 }
 
+void llama_load_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
+    idx_t count = duckdb_data_chunk_get_size(input);
+    duckdb_vector name_vector = duckdb_data_chunk_get_vector(input, 0);
+
+    for (idx_t i = 0; i < count; i++) {
+        char* name = get_string_from_vector(name_vector, i);
+
+        if (name) {
+            char* result = cpp_llama_model_load_status(name);
+            set_string_result(output, i, result ? result : "Error: Failed to get load status");
+            if (result) free(result);
+            duckdb_free(name);
+        } else {
+            set_string_result(output, i, "Error: Name parameter is required");
+        }
+    }
+}
+
 void llama_unload_model_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
     idx_t count = duckdb_data_chunk_get_size(input);
     duckdb_vector name_vector = duckdb_data_chunk_get_vector(input, 0);
@@ -218,24 +274,74 @@ void llama_generate_function(duckdb_function_info info, duckdb_data_chunk input,
     duckdb_vector model_vector = duckdb_data_chunk_get_vector(input, 0);
     duckdb_vector prompt_vector = duckdb_data_chunk_get_vector(input, 1);
     duckdb_vector options_vector = duckdb_data_chunk_get_vector(input, 2);
-    
+
+    /* Materialize the chunk up front: when every row targets the same model
+     * with the same options, the bridge fans the rows out across the model's
+     * context pool instead of generating one row at a time on this thread. */
+    char** models = (char**)malloc(count * sizeof(char*));
+    char** prompts = (char**)malloc(count * sizeof(char*));
+    char** options = (char**)malloc(count * sizeof(char*));
+    bool batchable = (models && prompts && options && count > 1);
+
     for (idx_t i = 0; i < count; i++) {
         char* model = get_string_from_vector(model_vector, i);
         char* prompt = get_string_from_vector(prompt_vector, i);
         char* options_json = get_string_from_vector(options_vector, i);
-        
-        if (model && prompt) {
-            char* result = cpp_llama_generate(model, prompt, options_json);
+        if (models) models[i] = model;
+        if (prompts) prompts[i] = prompt;
+        if (options) options[i] = options_json;
+        if (!model || !prompt ||
+            (i > 0 && models[0] && strcmp(models[0], model) != 0) ||
+            (i > 0 && options[0] && options_json && strcmp(options[0], options_json) != 0)) {
+            batchable = false;
+        }
+        if (!models || !prompts || !options) {
+            /* Allocation failure: degrade to the per-row path immediately. */
+            if (model && prompt) {
+                char* result = cpp_llama_generate(model, prompt, options_json);
+                set_string_result(output, i, result ? result : "Error: Failed to generate text");
+                if (result) free(result);
+            } else {
+                set_string_result(output, i, "Error: Model and prompt parameters are required");
+            }
+            if (model) duckdb_free(model);
+            if (prompt) duckdb_free(prompt);
+            if (options_json) duckdb_free(options_json);
+        }
+    }
+    if (!models || !prompts || !options) {
+        if (models) free(models);
+        if (prompts) free(prompts);
+        if (options) free(options);
+        return;
+    }
+
+    char** batch_results = NULL;
+    if (batchable) {
+        batch_results = cpp_llama_generate_batch(models[0], (const char* const*)prompts, count, options[0]);
+    }
+
+    for (idx_t i = 0; i < count; i++) {
+        if (batch_results) {
+            set_string_result(output, i, batch_results[i] ? batch_results[i] : "Error: Failed to generate text");
+            if (batch_results[i]) free(batch_results[i]);
+        } else if (models[i] && prompts[i]) {
+            char* result = cpp_llama_generate(models[i], prompts[i], options[i]);
             set_string_result(output, i, result ? result : "Error: Failed to generate text");
             if (result) free(result);
         } else {
             set_string_result(output, i, "Error: Model and prompt parameters are required");
         }
-        
-        if (model) duckdb_free(model);
-        if (prompt) duckdb_free(prompt);
-        if (options_json) duckdb_free(options_json);
+
+        if (models[i]) duckdb_free(models[i]);
+        if (prompts[i]) duckdb_free(prompts[i]);
+        if (options[i]) duckdb_free(options[i]);
     }
+
+    if (batch_results) free(batch_results);
+    free(models);
+    free(prompts);
+    free(options);
 }
 
 void llama_chat_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -267,22 +373,322 @@ void llama_embed_function(duckdb_function_info info, duckdb_data_chunk input, du
     idx_t count = duckdb_data_chunk_get_size(input);
     duckdb_vector model_vector = duckdb_data_chunk_get_vector(input, 0);
     duckdb_vector text_vector = duckdb_data_chunk_get_vector(input, 1);
-    
+
+    // Materialize the chunk up front: when every row targets the same model
+    // we can embed all rows in one multi-sequence decode instead of one
+    // llama_decode round-trip per row.
+    char** models = (char**)malloc(count * sizeof(char*));
+    char** texts = (char**)malloc(count * sizeof(char*));
+    bool batchable = (models && texts && count > 1);
+
     for (idx_t i = 0; i < count; i++) {
         char* model = get_string_from_vector(model_vector, i);
         char* text = get_string_from_vector(text_vector, i);
-        
-        if (model && text) {
-            char* result = cpp_llama_embed(model, text);
+        if (models) models[i] = model;
+        if (texts) texts[i] = text;
+        if (!model || !text || (i > 0 && models[0] && strcmp(models[0], model) != 0)) {
+            batchable = false;
+        }
+        if (!models || !texts) {
+            // Allocation failure: degrade to the per-row path immediately.
+            if (model && text) {
+                char* result = cpp_llama_embed(model, text);
+                set_string_result(output, i, result ? result : "Error: Failed to generate embeddings");
+                if (result) free(result);
+            } else {
+                set_string_result(output, i, "Error: Model and text parameters are required");
+            }
+            if (model) duckdb_free(model);
+            if (text) duckdb_free(text);
+        }
+    }
+    if (!models || !texts) {
+        if (models) free(models);
+        if (texts) free(texts);
+        return;
+    }
+
+    char** batch_results = NULL;
+    if (batchable) {
+        batch_results = cpp_llama_embed_batch(models[0], (const char* const*)texts, count);
+    }
+
+    for (idx_t i = 0; i < count; i++) {
+        if (batch_results) {
+            set_string_result(output, i, batch_results[i] ? batch_results[i] : "Error: Failed to generate embeddings");
+            if (batch_results[i]) free(batch_results[i]);
+        } else if (models[i] && texts[i]) {
+            char* result = cpp_llama_embed(models[i], texts[i]);
             set_string_result(output, i, result ? result : "Error: Failed to generate embeddings");
             if (result) free(result);
         } else {
             set_string_result(output, i, "Error: Model and text parameters are required");
         }
-        
-        if (model) duckdb_free(model);
-        if (text) duckdb_free(text);
+
+        if (models[i]) duckdb_free(models[i]);
+        if (texts[i]) duckdb_free(texts[i]);
     }
+
+    if (batch_results) free(batch_results);
+    free(models);
+    free(texts);
+}
+
+void llama_embed_list_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
+    idx_t count = duckdb_data_chunk_get_size(input);
+    duckdb_vector model_vector = duckdb_data_chunk_get_vector(input, 0);
+    duckdb_vector text_vector = duckdb_data_chunk_get_vector(input, 1);
+
+    char** models = (char**)malloc(count * sizeof(char*));
+    char** texts = (char**)malloc(count * sizeof(char*));
+    if (!models || !texts) {
+        if (models) free(models);
+        if (texts) free(texts);
+        duckdb_scalar_function_set_error(info, "trex_ai_embed_list: out of memory");
+        return;
+    }
+
+    bool batchable = (count > 1);
+    for (idx_t i = 0; i < count; i++) {
+        models[i] = get_string_from_vector(model_vector, i);
+        texts[i] = get_string_from_vector(text_vector, i);
+        if (!models[i] || !texts[i] || (i > 0 && models[0] && strcmp(models[0], models[i]) != 0)) {
+            batchable = false;
+        }
+    }
+
+    // Single multi-sequence decode when the whole chunk targets one model;
+    // per-row fallback otherwise. Either way the floats are written straight
+    // into the LIST child vector with no text serialization in between.
+    float** batch_vectors = NULL;
+    size_t batch_dim = 0;
+    if (batchable) {
+        batch_vectors = cpp_llama_embed_raw_batch(models[0], (const char* const*)texts, count, &batch_dim);
+    }
+
+    duckdb_list_entry* entries = (duckdb_list_entry*)duckdb_vector_get_data(output);
+    uint64_t* result_validity = NULL;
+    idx_t child_offset = 0;
+
+    for (idx_t i = 0; i < count; i++) {
+        float* vector_data = NULL;
+        size_t dim = 0;
+
+        if (batch_vectors) {
+            vector_data = batch_vectors[i];
+            dim = batch_dim;
+        } else if (models[i] && texts[i]) {
+            vector_data = cpp_llama_embed_raw(models[i], texts[i], &dim);
+        }
+
+        if (vector_data && dim > 0) {
+            duckdb_list_vector_reserve(output, child_offset + dim);
+            // Re-fetch the child data pointer: reserve may reallocate it.
+            duckdb_vector child = duckdb_list_vector_get_child(output);
+            float* child_data = (float*)duckdb_vector_get_data(child);
+            memcpy(child_data + child_offset, vector_data, dim * sizeof(float));
+            entries[i].offset = child_offset;
+            entries[i].length = dim;
+            child_offset += dim;
+        } else {
+            if (!result_validity) {
+                duckdb_vector_ensure_validity_writable(output);
+                result_validity = duckdb_vector_get_validity(output);
+            }
+            duckdb_validity_set_row_invalid(result_validity, i);
+            entries[i].offset = child_offset;
+            entries[i].length = 0;
+        }
+
+        if (vector_data) free(vector_data);
+        if (models[i]) duckdb_free(models[i]);
+        if (texts[i]) duckdb_free(texts[i]);
+    }
+
+    duckdb_list_vector_set_size(output, child_offset);
+
+    if (batch_vectors) free(batch_vectors);
+    free(models);
+    free(texts);
+}
+
+// Shared by the quantized embed variants: same materialize-then-batch
+// strategy as llama_embed_list_function, returning per-row fp32 vectors that
+// the caller quantizes before writing the DuckDB vector. On success *out_rows
+// holds `count` pointers (NULL for failed rows) of (*out_dims)[i] floats
+// each; the row pointers and both arrays are free()d by the caller.
+static bool embed_rows_raw(duckdb_data_chunk input, idx_t count,
+                           float*** out_rows, size_t** out_dims) {
+    duckdb_vector model_vector = duckdb_data_chunk_get_vector(input, 0);
+    duckdb_vector text_vector = duckdb_data_chunk_get_vector(input, 1);
+
+    char** models = (char**)malloc(count * sizeof(char*));
+    char** texts = (char**)malloc(count * sizeof(char*));
+    float** rows = (float**)malloc(count * sizeof(float*));
+    size_t* dims = (size_t*)malloc(count * sizeof(size_t));
+    if (!models || !texts || !rows || !dims) {
+        if (models) free(models);
+        if (texts) free(texts);
+        if (rows) free(rows);
+        if (dims) free(dims);
+        return false;
+    }
+
+    bool batchable = (count > 1);
+    for (idx_t i = 0; i < count; i++) {
+        models[i] = get_string_from_vector(model_vector, i);
+        texts[i] = get_string_from_vector(text_vector, i);
+        rows[i] = NULL;
+        dims[i] = 0;
+        if (!models[i] || !texts[i] || (i > 0 && models[0] && strcmp(models[0], models[i]) != 0)) {
+            batchable = false;
+        }
+    }
+
+    bool batched = false;
+    if (batchable) {
+        size_t batch_dim = 0;
+        float** batch_vectors = cpp_llama_embed_raw_batch(models[0], (const char* const*)texts, count, &batch_dim);
+        if (batch_vectors) {
+            for (idx_t i = 0; i < count; i++) {
+                rows[i] = batch_vectors[i];
+                dims[i] = rows[i] ? batch_dim : 0;
+            }
+            free(batch_vectors);
+            batched = true;
+        }
+    }
+    if (!batched) {
+        for (idx_t i = 0; i < count; i++) {
+            if (models[i] && texts[i]) {
+                rows[i] = cpp_llama_embed_raw(models[i], texts[i], &dims[i]);
+                if (!rows[i]) dims[i] = 0;
+            }
+        }
+    }
+
+    for (idx_t i = 0; i < count; i++) {
+        if (models[i]) duckdb_free(models[i]);
+        if (texts[i]) duckdb_free(texts[i]);
+    }
+    free(models);
+    free(texts);
+
+    *out_rows = rows;
+    *out_dims = dims;
+    return true;
+}
+
+void llama_embed_i8_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
+    idx_t count = duckdb_data_chunk_get_size(input);
+
+    float** rows = NULL;
+    size_t* dims = NULL;
+    if (!embed_rows_raw(input, count, &rows, &dims)) {
+        duckdb_scalar_function_set_error(info, "trex_ai_embed_i8: out of memory");
+        return;
+    }
+
+    // STRUCT(scale FLOAT, values TINYINT[]): symmetric scalar quantization,
+    // x ~= values[i] * scale, with the scale chosen per vector from its
+    // largest magnitude.
+    duckdb_vector scale_vector = duckdb_struct_vector_get_child(output, 0);
+    duckdb_vector values_vector = duckdb_struct_vector_get_child(output, 1);
+    float* scale_data = (float*)duckdb_vector_get_data(scale_vector);
+    duckdb_list_entry* entries = (duckdb_list_entry*)duckdb_vector_get_data(values_vector);
+    uint64_t* result_validity = NULL;
+    idx_t child_offset = 0;
+
+    for (idx_t i = 0; i < count; i++) {
+        size_t dim = dims[i];
+        if (rows[i] && dim > 0) {
+            float max_abs = 0.0f;
+            for (size_t j = 0; j < dim; j++) {
+                float a = rows[i][j] < 0 ? -rows[i][j] : rows[i][j];
+                if (a > max_abs) max_abs = a;
+            }
+            float scale = max_abs > 0.0f ? max_abs / 127.0f : 0.0f;
+
+            duckdb_list_vector_reserve(values_vector, child_offset + dim);
+            duckdb_vector child = duckdb_list_vector_get_child(values_vector);
+            int8_t* child_data = (int8_t*)duckdb_vector_get_data(child);
+            for (size_t j = 0; j < dim; j++) {
+                float q = scale > 0.0f ? rows[i][j] / scale : 0.0f;
+                q = q < 0 ? q - 0.5f : q + 0.5f;
+                int v = (int)q;
+                if (v > 127) v = 127;
+                if (v < -127) v = -127;
+                child_data[child_offset + j] = (int8_t)v;
+            }
+            scale_data[i] = scale;
+            entries[i].offset = child_offset;
+            entries[i].length = dim;
+            child_offset += dim;
+        } else {
+            if (!result_validity) {
+                duckdb_vector_ensure_validity_writable(output);
+                result_validity = duckdb_vector_get_validity(output);
+            }
+            duckdb_validity_set_row_invalid(result_validity, i);
+            scale_data[i] = 0.0f;
+            entries[i].offset = child_offset;
+            entries[i].length = 0;
+        }
+        if (rows[i]) free(rows[i]);
+    }
+
+    duckdb_list_vector_set_size(values_vector, child_offset);
+    free(rows);
+    free(dims);
+}
+
+void llama_embed_bit_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
+    idx_t count = duckdb_data_chunk_get_size(input);
+
+    float** rows = NULL;
+    size_t* dims = NULL;
+    if (!embed_rows_raw(input, count, &rows, &dims)) {
+        duckdb_scalar_function_set_error(info, "trex_ai_embed_bit: out of memory");
+        return;
+    }
+
+    // BLOB of ceil(dim/8) bytes; bit j (MSB-first) is set when component j
+    // is positive, for Hamming-distance retrieval.
+    uint8_t* blob = NULL;
+    size_t blob_cap = 0;
+    uint64_t* result_validity = NULL;
+
+    for (idx_t i = 0; i < count; i++) {
+        size_t dim = dims[i];
+        size_t blob_len = (dim + 7) / 8;
+        if (blob_len > blob_cap) {
+            uint8_t* grown = (uint8_t*)realloc(blob, blob_len);
+            if (grown) {
+                blob = grown;
+                blob_cap = blob_len;
+            }
+        }
+        if (rows[i] && dim > 0 && blob_cap >= blob_len) {
+            memset(blob, 0, blob_len);
+            for (size_t j = 0; j < dim; j++) {
+                if (rows[i][j] > 0.0f) {
+                    blob[j >> 3] |= (uint8_t)(0x80u >> (j & 7));
+                }
+            }
+            duckdb_vector_assign_string_element_len(output, i, (const char*)blob, blob_len);
+        } else {
+            if (!result_validity) {
+                duckdb_vector_ensure_validity_writable(output);
+                result_validity = duckdb_vector_get_validity(output);
+            }
+            duckdb_validity_set_row_invalid(result_validity, i);
+        }
+        if (rows[i]) free(rows[i]);
+    }
+
+    if (blob) free(blob);
+    free(rows);
+    free(dims);
 }
 
 void llama_batch_process_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -321,6 +727,18 @@ void llama_get_batch_result_function(duckdb_function_info info, duckdb_data_chun
     }
 }
 
+void llama_batch_results_since_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
+    idx_t count = duckdb_data_chunk_get_size(input);
+    int64_t* cursor_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(input, 0));
+
+    for (idx_t i = 0; i < count; i++) {
+        int64_t cursor = cursor_data ? cursor_data[i] : 0;
+        char* result = cpp_llama_batch_results_since(cursor < 0 ? 0 : (uint64_t)cursor);
+        set_string_result(output, i, result ? result : "Error: Failed to get batch results");
+        if (result) free(result);
+    }
+}
+
 void llama_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
     idx_t count = duckdb_data_chunk_get_size(input);
     
@@ -369,6 +787,52 @@ typedef struct {
     bool finished;
 } llama_stream_generate_state;
 
+// Parses one token JSON from the bridge and writes it to the given output
+// row. Returns true when the token is the final (end-of-stream) marker, which
+// is written as an empty string with is_final set.
+static bool llama_stream_write_token_row(const char* token_result, duckdb_vector token_vector,
+                                         duckdb_vector is_final_vector, idx_t row) {
+    bool is_final = false;
+
+    const char* is_final_pos = strstr(token_result, "\"is_final\":");
+    if (is_final_pos) {
+        is_final_pos += 11;
+        while (*is_final_pos == ' ') is_final_pos++;
+        is_final = (strncmp(is_final_pos, "true", 4) == 0);
+    }
+
+    if (!is_final) {
+        duckdb_vector_assign_string_element(token_vector, row, "");
+        const char* token_start = strstr(token_result, "\"token\":");
+        if (token_start) {
+            token_start += 8;
+            while (*token_start == ' ' || *token_start == '"') token_start++;
+            const char* token_end = token_start;
+            while (*token_end && *token_end != '"') {
+                if (*token_end == '\\') token_end++;
+                token_end++;
+            }
+
+            if (token_end > token_start) {
+                size_t token_len = token_end - token_start;
+                char* extracted_token = malloc(token_len + 1);
+                if (extracted_token) {
+                    strncpy(extracted_token, token_start, token_len);
+                    extracted_token[token_len] = '\0';
+                    duckdb_vector_assign_string_element(token_vector, row, extracted_token);
+                    free(extracted_token);
+                }
+            }
+        }
+    } else {
+        duckdb_vector_assign_string_element(token_vector, row, "");
+    }
+
+    bool* is_final_data = (bool*)duckdb_vector_get_data(is_final_vector);
+    is_final_data[row] = is_final;
+    return is_final;
+}
+
 static void llama_stream_generate_state_destroy(void* ptr) {
     llama_stream_generate_state* state = (llama_stream_generate_state*)ptr;
     if (state) {
@@ -478,66 +942,43 @@ void llama_stream_generate_function(duckdb_function_info info, duckdb_data_chunk
             return;
         }
     }
-    
-    
+
+
     if (state->session_id) {
-        char* token_result = cpp_llama_get_stream_token(state->session_id);
-
-        if (token_result) {
-            duckdb_vector token_vector = duckdb_data_chunk_get_vector(output, 0);
-            duckdb_vector is_final_vector = duckdb_data_chunk_get_vector(output, 1);
-            bool is_final = false;
-
-            const char* is_final_pos = strstr(token_result, "\"is_final\":");
-            if (is_final_pos) {
-                is_final_pos += 11; 
-                while (*is_final_pos == ' ') is_final_pos++;
-                is_final = (strncmp(is_final_pos, "true", 4) == 0);
-            }
-            
-            if (!is_final) {
-                const char* token_start = strstr(token_result, "\"token\":");
-                if (token_start) {
-                    token_start += 8; 
-                    while (*token_start == ' ' || *token_start == '"') token_start++;
-                    const char* token_end = token_start;
-                    while (*token_end && *token_end != '"') {
-                        if (*token_end == '\\') token_end++; 
-                        token_end++;
-                    }
-                    
-                    if (token_end > token_start) {
-                        size_t token_len = token_end - token_start;
-                        char* extracted_token = malloc(token_len + 1);
-                        if (extracted_token) {
-                            strncpy(extracted_token, token_start, token_len);
-                            extracted_token[token_len] = '\0';
-                            duckdb_vector_assign_string_element(token_vector, 0, extracted_token);
-                            free(extracted_token);
-                        }
-                    }
-                }
-            } else {
-                duckdb_vector_assign_string_element(token_vector, 0, "");
-                state->finished = true;
-                
-                
-                if (state->session_id) {
-                    cpp_llama_stop_streaming(state->session_id);
-                    free(state->session_id);
-                    state->session_id = NULL;
+        duckdb_vector token_vector = duckdb_data_chunk_get_vector(output, 0);
+        duckdb_vector is_final_vector = duckdb_data_chunk_get_vector(output, 1);
+        idx_t capacity = duckdb_vector_size();
+        idx_t row = 0;
+
+        // Block for the first token only, then drain whatever the generator
+        // has already queued into the same (partial) chunk. The chunk goes
+        // back to the engine as soon as the queue is empty, so streaming
+        // stays responsive at the full 2048-row vector size.
+        while (row < capacity && !state->finished) {
+            char* token_result = (row == 0)
+                ? cpp_llama_get_stream_token(state->session_id)
+                : cpp_llama_try_get_stream_token(state->session_id);
+
+            if (!token_result) {
+                if (row == 0) {
+                    state->finished = true;
                 }
+                break;
             }
-            
-            
-            bool* is_final_data = (bool*)duckdb_vector_get_data(is_final_vector);
-            is_final_data[0] = is_final;
-            
-            duckdb_data_chunk_set_size(output, 1);
+
+            bool is_final = llama_stream_write_token_row(token_result, token_vector, is_final_vector, row);
+            row++;
             free(token_result);
-        } else {
-            state->finished = true;
+
+            if (is_final) {
+                state->finished = true;
+                cpp_llama_stop_streaming(state->session_id);
+                free(state->session_id);
+                state->session_id = NULL;
+            }
         }
+
+        duckdb_data_chunk_set_size(output, row);
     }
 }
 
@@ -670,66 +1111,40 @@ void llama_stream_chat_function(duckdb_function_info info, duckdb_data_chunk out
             return;
         }
     }
-    
-    
+
+
     if (state->session_id) {
-        char* token_result = cpp_llama_get_stream_token(state->session_id);
-        
-        if (token_result) {
-            duckdb_vector token_vector = duckdb_data_chunk_get_vector(output, 0);
-            duckdb_vector is_final_vector = duckdb_data_chunk_get_vector(output, 1);
-            bool is_final = false;
-
-            const char* is_final_pos = strstr(token_result, "\"is_final\":");
-            if (is_final_pos) {
-                is_final_pos += 11; 
-                while (*is_final_pos == ' ') is_final_pos++;
-                is_final = (strncmp(is_final_pos, "true", 4) == 0);
-            }
-            
-            if (!is_final) {
-                const char* token_start = strstr(token_result, "\"token\":");
-                if (token_start) {
-                    token_start += 8; 
-                    while (*token_start == ' ' || *token_start == '"') token_start++;
-                    const char* token_end = token_start;
-                    while (*token_end && *token_end != '"') {
-                        if (*token_end == '\\') token_end++; 
-                        token_end++;
-                    }
-                    
-                    if (token_end > token_start) {
-                        size_t token_len = token_end - token_start;
-                        char* extracted_token = malloc(token_len + 1);
-                        if (extracted_token) {
-                            strncpy(extracted_token, token_start, token_len);
-                            extracted_token[token_len] = '\0';
-                            duckdb_vector_assign_string_element(token_vector, 0, extracted_token);
-                            free(extracted_token);
-                        }
-                    }
-                }
-            } else {
-                duckdb_vector_assign_string_element(token_vector, 0, "");
-                state->finished = true;
-                
-                
-                if (state->session_id) {
-                    cpp_llama_stop_streaming(state->session_id);
-                    free(state->session_id);
-                    state->session_id = NULL;
+        duckdb_vector token_vector = duckdb_data_chunk_get_vector(output, 0);
+        duckdb_vector is_final_vector = duckdb_data_chunk_get_vector(output, 1);
+        idx_t capacity = duckdb_vector_size();
+        idx_t row = 0;
+
+        // Same partial-chunk strategy as llama_stream_generate_function.
+        while (row < capacity && !state->finished) {
+            char* token_result = (row == 0)
+                ? cpp_llama_get_stream_token(state->session_id)
+                : cpp_llama_try_get_stream_token(state->session_id);
+
+            if (!token_result) {
+                if (row == 0) {
+                    state->finished = true;
                 }
+                break;
             }
-            
-            
-            bool* is_final_data = (bool*)duckdb_vector_get_data(is_final_vector);
-            is_final_data[0] = is_final;
-            
-            duckdb_data_chunk_set_size(output, 1);
+
+            bool is_final = llama_stream_write_token_row(token_result, token_vector, is_final_vector, row);
+            row++;
             free(token_result);
-        } else {
-            state->finished = true;
+
+            if (is_final) {
+                state->finished = true;
+                cpp_llama_stop_streaming(state->session_id);
+                free(state->session_id);
+                state->session_id = NULL;
+            }
         }
+
+        duckdb_data_chunk_set_size(output, row);
     }
 }
 
@@ -743,6 +1158,232 @@ void llama_get_performance_metrics_function(duckdb_function_info info, duckdb_da
     }
 }
 
+/* trex_ai_latency_metrics(): one row per (model, phase) with percentile
+ * latencies, shaped so a scrape job can forward rows to Prometheus as-is.
+ * The snapshot is taken once at init; the function call streams it out. */
+typedef struct {
+    cpp_llama_latency_row* rows;
+    size_t row_count;
+    size_t next_row;
+} llama_latency_metrics_state;
+
+static void llama_latency_metrics_state_destroy(void* ptr) {
+    llama_latency_metrics_state* state = (llama_latency_metrics_state*)ptr;
+    if (state) {
+        cpp_llama_free_latency_rows(state->rows, state->row_count);
+        free(state);
+    }
+}
+
+void llama_latency_metrics_bind(duckdb_bind_info info) {
+    duckdb_bind_add_result_column(info, "model", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "metric", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "count", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "mean_ms", duckdb_create_logical_type(DUCKDB_TYPE_DOUBLE));
+    duckdb_bind_add_result_column(info, "p50_ms", duckdb_create_logical_type(DUCKDB_TYPE_DOUBLE));
+    duckdb_bind_add_result_column(info, "p95_ms", duckdb_create_logical_type(DUCKDB_TYPE_DOUBLE));
+    duckdb_bind_add_result_column(info, "p99_ms", duckdb_create_logical_type(DUCKDB_TYPE_DOUBLE));
+    duckdb_bind_add_result_column(info, "max_ms", duckdb_create_logical_type(DUCKDB_TYPE_DOUBLE));
+}
+
+void llama_latency_metrics_init(duckdb_init_info info) {
+    llama_latency_metrics_state* state = malloc(sizeof(llama_latency_metrics_state));
+    state->rows = cpp_llama_latency_rows(&state->row_count);
+    state->next_row = 0;
+    duckdb_init_set_init_data(info, state, llama_latency_metrics_state_destroy);
+}
+
+void llama_latency_metrics_function(duckdb_function_info info, duckdb_data_chunk output) {
+    llama_latency_metrics_state* state = (llama_latency_metrics_state*)duckdb_function_get_init_data(info);
+
+    duckdb_vector model_vector = duckdb_data_chunk_get_vector(output, 0);
+    duckdb_vector metric_vector = duckdb_data_chunk_get_vector(output, 1);
+    int64_t* count_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 2));
+    double* mean_data = (double*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 3));
+    double* p50_data = (double*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 4));
+    double* p95_data = (double*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 5));
+    double* p99_data = (double*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 6));
+    double* max_data = (double*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 7));
+
+    idx_t capacity = duckdb_vector_size();
+    idx_t row = 0;
+    while (row < capacity && state->next_row < state->row_count) {
+        cpp_llama_latency_row* src = &state->rows[state->next_row];
+        duckdb_vector_assign_string_element(model_vector, row, src->model ? src->model : "");
+        duckdb_vector_assign_string_element(metric_vector, row, src->metric ? src->metric : "");
+        count_data[row] = (int64_t)src->count;
+        mean_data[row] = src->mean_ms;
+        p50_data[row] = src->p50_ms;
+        p95_data[row] = src->p95_ms;
+        p99_data[row] = src->p99_ms;
+        max_data[row] = src->max_ms;
+        row++;
+        state->next_row++;
+    }
+
+    duckdb_data_chunk_set_size(output, row);
+}
+
+/* trex_ai_trace(): streams the trace ring's recent spans as
+ * (span, start_ns, duration_ns, thread_id) rows for SQL aggregation. The
+ * snapshot is taken once at init; the function call streams it out. */
+typedef struct {
+    trace_ring_span_t* spans;
+    size_t count;
+    size_t next;
+} llama_trace_state;
+
+static void llama_trace_state_destroy(void* ptr) {
+    llama_trace_state* state = (llama_trace_state*)ptr;
+    if (state) {
+        free(state->spans);
+        free(state);
+    }
+}
+
+void llama_trace_bind(duckdb_bind_info info) {
+    duckdb_bind_add_result_column(info, "span", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "start_ns", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "duration_ns", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "thread_id", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+}
+
+void llama_trace_init(duckdb_init_info info) {
+    llama_trace_state* state = malloc(sizeof(llama_trace_state));
+    state->spans = trace_ring_snapshot(&state->count);
+    state->next = 0;
+    duckdb_init_set_init_data(info, state, llama_trace_state_destroy);
+}
+
+void llama_trace_function(duckdb_function_info info, duckdb_data_chunk output) {
+    llama_trace_state* state = (llama_trace_state*)duckdb_function_get_init_data(info);
+
+    duckdb_vector span_vector = duckdb_data_chunk_get_vector(output, 0);
+    int64_t* start_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 1));
+    int64_t* duration_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 2));
+    int64_t* thread_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 3));
+
+    idx_t capacity = duckdb_vector_size();
+    idx_t row = 0;
+    while (row < capacity && state->next < state->count) {
+        trace_ring_span_t* src = &state->spans[state->next];
+        duckdb_vector_assign_string_element(span_vector, row, src->span ? src->span : "");
+        start_data[row] = (int64_t)src->start_ns;
+        duration_data[row] = (int64_t)src->duration_ns;
+        thread_data[row] = (int64_t)src->thread_id;
+        row++;
+        state->next++;
+    }
+
+    duckdb_data_chunk_set_size(output, row);
+}
+
+/* trex_ai_gguf_info(path): metadata-only GGUF reader. The bridge mmaps the
+ * file and walks just the header/KV/tensor-descriptor section, so describing
+ * a multi-GB model on disk faults in a few metadata pages instead of loading
+ * the model. Emits exactly one row per call. */
+typedef struct {
+    char* path;
+} llama_gguf_info_bind_data;
+
+typedef struct {
+    bool emitted;
+} llama_gguf_info_state;
+
+static void llama_gguf_info_bind_data_destroy(void* ptr) {
+    llama_gguf_info_bind_data* bind_data = (llama_gguf_info_bind_data*)ptr;
+    if (bind_data) {
+        free(bind_data->path);
+        free(bind_data);
+    }
+}
+
+void llama_gguf_info_bind(duckdb_bind_info info) {
+    duckdb_bind_add_result_column(info, "path", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "gguf_version", duckdb_create_logical_type(DUCKDB_TYPE_INTEGER));
+    duckdb_bind_add_result_column(info, "architecture", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "quantization", duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR));
+    duckdb_bind_add_result_column(info, "parameter_count", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "context_length", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "embedding_length", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+    duckdb_bind_add_result_column(info, "tensor_count", duckdb_create_logical_type(DUCKDB_TYPE_BIGINT));
+
+    llama_gguf_info_bind_data* bind_data = malloc(sizeof(llama_gguf_info_bind_data));
+    duckdb_value path_value = duckdb_bind_get_parameter(info, 0);
+    char* path = duckdb_get_varchar(path_value);
+    bind_data->path = path ? strdup(path) : NULL;
+    if (path) duckdb_free(path);
+    duckdb_destroy_value(&path_value);
+    duckdb_bind_set_bind_data(info, bind_data, llama_gguf_info_bind_data_destroy);
+}
+
+void llama_gguf_info_init(duckdb_init_info info) {
+    llama_gguf_info_state* state = malloc(sizeof(llama_gguf_info_state));
+    state->emitted = false;
+    duckdb_init_set_init_data(info, state, free);
+}
+
+void llama_gguf_info_function(duckdb_function_info info, duckdb_data_chunk output) {
+    llama_gguf_info_bind_data* bind_data = (llama_gguf_info_bind_data*)duckdb_function_get_bind_data(info);
+    llama_gguf_info_state* state = (llama_gguf_info_state*)duckdb_function_get_init_data(info);
+
+    if (state->emitted || !bind_data->path) {
+        duckdb_data_chunk_set_size(output, 0);
+        return;
+    }
+    state->emitted = true;
+
+    struct cpp_llama_gguf_info_t gguf;
+    cpp_llama_gguf_info(bind_data->path, &gguf);
+    if (gguf.error) {
+        duckdb_function_set_error(info, gguf.error);
+        cpp_llama_free_gguf_info(&gguf);
+        duckdb_data_chunk_set_size(output, 0);
+        return;
+    }
+
+    duckdb_vector path_vector = duckdb_data_chunk_get_vector(output, 0);
+    duckdb_vector version_vector = duckdb_data_chunk_get_vector(output, 1);
+    duckdb_vector arch_vector = duckdb_data_chunk_get_vector(output, 2);
+    duckdb_vector quant_vector = duckdb_data_chunk_get_vector(output, 3);
+    duckdb_vector params_vector = duckdb_data_chunk_get_vector(output, 4);
+    duckdb_vector context_vector = duckdb_data_chunk_get_vector(output, 5);
+    duckdb_vector embedding_vector = duckdb_data_chunk_get_vector(output, 6);
+    duckdb_vector tensors_vector = duckdb_data_chunk_get_vector(output, 7);
+
+    duckdb_vector_assign_string_element(path_vector, 0, bind_data->path);
+    ((int32_t*)duckdb_vector_get_data(version_vector))[0] = (int32_t)gguf.gguf_version;
+    if (gguf.architecture) {
+        duckdb_vector_assign_string_element(arch_vector, 0, gguf.architecture);
+    } else {
+        duckdb_vector_ensure_validity_writable(arch_vector);
+        duckdb_validity_set_row_invalid(duckdb_vector_get_validity(arch_vector), 0);
+    }
+    if (gguf.quantization) {
+        duckdb_vector_assign_string_element(quant_vector, 0, gguf.quantization);
+    } else {
+        duckdb_vector_ensure_validity_writable(quant_vector);
+        duckdb_validity_set_row_invalid(duckdb_vector_get_validity(quant_vector), 0);
+    }
+    ((int64_t*)duckdb_vector_get_data(params_vector))[0] = (int64_t)gguf.parameter_count;
+    if (gguf.context_length) {
+        ((int64_t*)duckdb_vector_get_data(context_vector))[0] = (int64_t)gguf.context_length;
+    } else {
+        duckdb_vector_ensure_validity_writable(context_vector);
+        duckdb_validity_set_row_invalid(duckdb_vector_get_validity(context_vector), 0);
+    }
+    if (gguf.embedding_length) {
+        ((int64_t*)duckdb_vector_get_data(embedding_vector))[0] = (int64_t)gguf.embedding_length;
+    } else {
+        duckdb_vector_ensure_validity_writable(embedding_vector);
+        duckdb_validity_set_row_invalid(duckdb_vector_get_validity(embedding_vector), 0);
+    }
+    ((int64_t*)duckdb_vector_get_data(tensors_vector))[0] = (int64_t)gguf.tensor_count;
+
+    cpp_llama_free_gguf_info(&gguf);
+    duckdb_data_chunk_set_size(output, 1);
+}
+
 void llama_get_memory_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
     idx_t count = duckdb_data_chunk_get_size(input);
     
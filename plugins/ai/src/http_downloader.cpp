@@ -4,6 +4,12 @@
 #include <fstream>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -15,6 +21,8 @@
     #include <netdb.h>
     #include <arpa/inet.h>
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
 #endif
 
 namespace llama_capi {
@@ -49,6 +57,14 @@ HttpDownloader::DownloadResult HttpDownloader::download_file(const std::string&
 #ifdef _WIN32
         return download_windows(host, path, port, is_https, output_path);
 #else
+        // Big bodies from range-capable servers go down the segmented
+        // parallel path; everything else keeps the single-stream fallback.
+        size_t total_size = 0;
+        bool accepts_ranges = false;
+        if (probe_unix(host, path, port, is_https, total_size, accepts_ranges) &&
+            accepts_ranges && total_size >= 32ULL * 1024 * 1024) {
+            return download_ranged_unix(host, path, port, is_https, output_path, total_size);
+        }
         return download_unix(host, path, port, is_https, output_path);
 #endif
     } catch (const std::exception& e) {
@@ -151,6 +167,7 @@ HttpDownloader::DownloadResult HttpDownloader::download_unix(const std::string&
         int rc = std::system(cmd.c_str());
         if (rc == 0 && std::filesystem::exists(output_path)) {
             result.bytes_downloaded = std::filesystem::file_size(output_path);
+            result.content_hash = warm_and_hash(output_path);
             result.success = true;
             return result;
         }
@@ -254,11 +271,361 @@ HttpDownloader::DownloadResult HttpDownloader::download_unix(const std::string&
     }
     
     output_file.write(body.data(), body.size());
+    output_file.close();
     result.bytes_downloaded = body.size();
+    result.content_hash = warm_and_hash(output_path);
     result.success = true;
-    
+
     return result;
 }
+
+bool HttpDownloader::probe_unix(const std::string& host, const std::string& path,
+                                int port, bool is_https, size_t& total_size, bool& accepts_ranges) {
+    total_size = 0;
+    accepts_ranges = false;
+
+    std::string headers;
+    if (is_https) {
+        // Same curl fallback as the body fetch; -I issues a HEAD, -L follows
+        // the redirects HuggingFace serves for resolve/ URLs.
+        std::string url = "https://" + host + (port == 443 ? "" : ":" + std::to_string(port)) + path;
+        std::string cmd = "curl -fsIL --max-time 60 '" + url + "'";
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (!pipe) {
+            return false;
+        }
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            headers.append(buffer, n);
+        }
+        if (pclose(pipe) != 0) {
+            return false;
+        }
+    } else {
+        struct hostent* server = gethostbyname(host.c_str());
+        if (!server) {
+            return false;
+        }
+        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd < 0) {
+            return false;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = 30;
+        timeout.tv_usec = 0;
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        struct sockaddr_in serv_addr;
+        memset(&serv_addr, 0, sizeof(serv_addr));
+        serv_addr.sin_family = AF_INET;
+        serv_addr.sin_port = htons(port);
+        memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+        if (connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
+            close(sockfd);
+            return false;
+        }
+
+        std::string request = "HEAD " + path + " HTTP/1.1\r\n";
+        request += "Host: " + host + "\r\n";
+        request += "User-Agent: trexsql-ai/1.0\r\n";
+        request += "Connection: close\r\n";
+        request += "\r\n";
+        if (send(sockfd, request.c_str(), request.length(), 0) < 0) {
+            close(sockfd);
+            return false;
+        }
+
+        char buffer[4096];
+        ssize_t bytes_received;
+        while ((bytes_received = recv(sockfd, buffer, sizeof(buffer), 0)) > 0) {
+            headers.append(buffer, bytes_received);
+        }
+        close(sockfd);
+    }
+
+    // Redirect chains stack header blocks; only the final one describes the
+    // body, so the last match of each header wins.
+    std::regex length_regex(R"([Cc]ontent-[Ll]ength:\s*(\d+))");
+    auto begin = std::sregex_iterator(headers.begin(), headers.end(), length_regex);
+    for (auto it = begin; it != std::sregex_iterator(); ++it) {
+        total_size = std::stoull((*it)[1].str());
+    }
+
+    std::regex ranges_regex(R"([Aa]ccept-[Rr]anges:\s*bytes)");
+    auto ranges_begin = std::sregex_iterator(headers.begin(), headers.end(), ranges_regex);
+    accepts_ranges = ranges_begin != std::sregex_iterator();
+
+    return total_size > 0;
+}
+
+bool HttpDownloader::fetch_range_unix(const std::string& host, const std::string& path,
+                                      int port, bool is_https, size_t offset, size_t length, int fd) {
+    size_t end = offset + length - 1;
+
+    if (is_https) {
+        std::string url = "https://" + host + (port == 443 ? "" : ":" + std::to_string(port)) + path;
+        std::string cmd = "curl -fsSL --max-time 600 -r " + std::to_string(offset) + "-" +
+                          std::to_string(end) + " '" + url + "'";
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (!pipe) {
+            return false;
+        }
+        std::vector<char> buffer(256 * 1024);
+        size_t written = 0;
+        size_t n;
+        bool ok = true;
+        while ((n = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+            if (written + n > length ||
+                pwrite(fd, buffer.data(), n, (off_t)(offset + written)) != (ssize_t)n) {
+                ok = false;
+                break;
+            }
+            written += n;
+        }
+        if (pclose(pipe) != 0) {
+            ok = false;
+        }
+        return ok && written == length;
+    }
+
+    struct hostent* server = gethostbyname(host.c_str());
+    if (!server) {
+        return false;
+    }
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        return false;
+    }
+    struct timeval timeout;
+    timeout.tv_sec = 30;
+    timeout.tv_usec = 0;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in serv_addr;
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(port);
+    memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+    if (connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
+        close(sockfd);
+        return false;
+    }
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host + "\r\n";
+    request += "User-Agent: trexsql-ai/1.0\r\n";
+    request += "Range: bytes=" + std::to_string(offset) + "-" + std::to_string(end) + "\r\n";
+    request += "Connection: close\r\n";
+    request += "\r\n";
+    if (send(sockfd, request.c_str(), request.length(), 0) < 0) {
+        close(sockfd);
+        return false;
+    }
+
+    // Collect headers, then stream the body straight to its file offset.
+    std::string head;
+    std::vector<char> buffer(256 * 1024);
+    size_t body_start = std::string::npos;
+    ssize_t bytes_received;
+    size_t written = 0;
+    bool ok = true;
+
+    while ((bytes_received = recv(sockfd, buffer.data(), buffer.size(), 0)) > 0) {
+        size_t consumed = 0;
+        if (body_start == std::string::npos) {
+            head.append(buffer.data(), bytes_received);
+            body_start = head.find("\r\n\r\n");
+            if (body_start == std::string::npos) {
+                continue;
+            }
+            if (head.find("HTTP/1.1 206") != 0 && head.find("HTTP/1.0 206") != 0) {
+                ok = false;
+                break;
+            }
+            // Replay whatever body bytes arrived with the header block.
+            size_t spill = head.size() - (body_start + 4);
+            if (spill > 0) {
+                if (spill > length ||
+                    pwrite(fd, head.data() + body_start + 4, spill, (off_t)offset) != (ssize_t)spill) {
+                    ok = false;
+                    break;
+                }
+                written = spill;
+            }
+            consumed = bytes_received;
+        }
+        if (consumed == 0) {
+            if (written + bytes_received > length ||
+                pwrite(fd, buffer.data(), bytes_received, (off_t)(offset + written)) != bytes_received) {
+                ok = false;
+                break;
+            }
+            written += bytes_received;
+        }
+    }
+
+    close(sockfd);
+    return ok && written == length;
+}
+
+HttpDownloader::DownloadResult HttpDownloader::download_ranged_unix(const std::string& host, const std::string& path,
+                                                                    int port, bool is_https,
+                                                                    const std::filesystem::path& output_path,
+                                                                    size_t total_size) {
+    DownloadResult result;
+
+    constexpr size_t kSegmentSize = 64ULL * 1024 * 1024;
+    constexpr size_t kMaxConnections = 4;
+    const size_t n_segments = (total_size + kSegmentSize - 1) / kSegmentSize;
+
+    std::filesystem::path part_path = output_path;
+    part_path += ".part";
+    std::filesystem::path meta_path = output_path;
+    meta_path += ".segments";
+
+    // Resume state: the sidecar holds the expected size, the segment size
+    // and a '0'/'1' char per segment. Any mismatch invalidates it.
+    std::string bitmap(n_segments, '0');
+    {
+        std::ifstream meta(meta_path);
+        size_t recorded_size = 0, recorded_segment = 0;
+        std::string recorded_bitmap;
+        if (meta >> recorded_size >> recorded_segment >> recorded_bitmap &&
+            recorded_size == total_size && recorded_segment == kSegmentSize &&
+            recorded_bitmap.size() == n_segments &&
+            std::filesystem::exists(part_path)) {
+            bitmap = recorded_bitmap;
+        }
+    }
+
+    int fd = open(part_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        result.error_message = "Failed to create output file";
+        return result;
+    }
+    // Preallocate so parallel pwrites land inside the file. Real block
+    // allocation (not just a sparse size) avoids fragmenting 8GB GGUFs
+    // written out of order; older filesystems fall back to ftruncate.
+    bool preallocated = false;
+#ifdef __linux__
+    preallocated = fallocate(fd, 0, 0, (off_t)total_size) == 0;
 #endif
+    if (!preallocated && ftruncate(fd, (off_t)total_size) != 0) {
+        close(fd);
+        result.error_message = "Failed to preallocate output file";
+        return result;
+    }
+
+    std::mutex meta_mutex;
+    std::atomic<size_t> next_segment{0};
+    std::atomic<bool> failed{false};
+
+    auto persist_meta = [&]() {
+        // Rewrite-and-rename so a crash never leaves a torn bitmap.
+        std::filesystem::path tmp = meta_path;
+        tmp += ".tmp";
+        std::ofstream meta(tmp, std::ios::trunc);
+        meta << total_size << " " << kSegmentSize << "\n" << bitmap << "\n";
+        meta.close();
+        std::error_code ec;
+        std::filesystem::rename(tmp, meta_path, ec);
+    };
 
-} 
+    auto worker = [&]() {
+        size_t idx;
+        while ((idx = next_segment.fetch_add(1)) < n_segments && !failed.load()) {
+            if (bitmap[idx] == '1') {
+                continue;  // finished in a previous run
+            }
+            size_t offset = idx * kSegmentSize;
+            size_t length = std::min(kSegmentSize, total_size - offset);
+
+            bool ok = false;
+            for (int attempt = 0; attempt < 3 && !ok && !failed.load(); ++attempt) {
+                ok = fetch_range_unix(host, path, port, is_https, offset, length, fd);
+            }
+            if (!ok) {
+                failed = true;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(meta_mutex);
+            bitmap[idx] = '1';
+            persist_meta();
+        }
+    };
+
+    size_t n_workers = std::min(kMaxConnections, n_segments);
+    std::vector<std::thread> threads;
+    threads.reserve(n_workers);
+    for (size_t i = 0; i < n_workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    close(fd);
+
+    if (failed.load()) {
+        // Keep .part and the bitmap: the next call resumes from here.
+        size_t done = (size_t)std::count(bitmap.begin(), bitmap.end(), '1');
+        result.bytes_downloaded = done * kSegmentSize;
+        result.error_message = "Ranged download failed after " + std::to_string(done) + "/" +
+                               std::to_string(n_segments) + " segments (will resume)";
+        return result;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(part_path, output_path, ec);
+    if (ec) {
+        result.error_message = "Failed to move completed download into place";
+        return result;
+    }
+    std::filesystem::remove(meta_path, ec);
+
+    result.bytes_downloaded = total_size;
+    result.content_hash = warm_and_hash(output_path);
+    result.success = true;
+    return result;
+}
+
+// Most segment pages are still cache-resident from their pwrites, so this
+// pass mostly folds bytes into the hash; anything already evicted is
+// faulted back in, which is exactly the readback llama_model_load_from_file
+// would otherwise pay cold.
+uint64_t HttpDownloader::warm_and_hash(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size <= 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* mapped = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+    madvise(mapped, (size_t)size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+    // FNV-1a, 64-bit.
+    uint64_t hash = 1469598103934665603ULL;
+    const unsigned char* data = (const unsigned char*)mapped;
+    for (off_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    munmap(mapped, (size_t)size);
+    close(fd);
+    return hash;
+}
+#endif
+
+}
@@ -6,8 +6,11 @@
 #include <chrono>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include <filesystem>
 #include <queue>
+#include <deque>
+#include <list>
 #include <atomic>
 #include <thread>
 #include <condition_variable>
@@ -17,6 +20,7 @@
 struct llama_model;
 struct llama_context;
 struct llama_sampler;
+struct llama_vocab;
 
 namespace llama_capi {
 
@@ -36,6 +40,35 @@ struct ModelConfig {
     // which causes llama.cpp to pick the architecture's default (CLS for BERT,
     // MEAN for nomic-embed, etc.). 0 = NONE (per-token, used by decoder LLMs).
     int pooling_type = -1;
+    // Maximum number of sequences packed into a single llama_batch. Values > 1
+    // enable multi-sequence decodes (batched embedding of a whole data chunk);
+    // 1 preserves the old one-sequence-per-decode behavior.
+    int n_seq_max = 16;
+    // Speculative decoding: optional small draft model paired with this
+    // target. When set, greedy (temperature <= 0) generation proposes
+    // draft_n_tokens per step with the draft and verifies them against the
+    // target in one batched decode. Empty = speculative decoding off.
+    std::string draft_model_path;
+    int draft_n_tokens = 5;
+    // Device placement. main_gpu picks the device that hosts the model (and
+    // small tensors when split across devices). tensor_split gives the
+    // per-device proportion of layers; empty = everything on main_gpu. A
+    // non-empty split enables layer-mode splitting, e.g. {0, 1, 1, 1} keeps
+    // device 0 free and spreads the model over devices 1-3.
+    int main_gpu = 0;
+    std::vector<float> tensor_split;
+};
+
+// One entry per ggml backend device, as enumerated at runtime. The CPU
+// backend always appears, so callers filter on is_gpu when they only care
+// about offload targets.
+struct GPUDeviceInfo {
+    int index = 0;
+    std::string name;
+    std::string description;
+    size_t memory_free = 0;
+    size_t memory_total = 0;
+    bool is_gpu = false;
 };
 
 struct ChatMessage {
@@ -57,6 +90,50 @@ struct GenerationParams {
 };
 
 
+// HDR-style latency histogram. Microsecond samples land in log2-spaced
+// buckets via a single atomic increment, so hot-path recording never takes a
+// lock; percentile queries scan the 48 buckets on demand.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 48;
+
+    void Record(uint64_t value_us);
+    uint64_t Count() const;
+    double MeanMs() const;
+    double MaxMs() const;
+    // pct in [0, 100]; returns the upper bound of the bucket containing the
+    // requested percentile, in milliseconds.
+    double PercentileMs(double pct) const;
+    void Reset();
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+// Per-model latency breakdown along the phases our SLOs care about.
+struct ModelLatencyMetrics {
+    LatencyHistogram prefill;  // prompt evaluation
+    LatencyHistogram decode;   // each generated token's decode step
+    LatencyHistogram ttft;     // time to first token
+    LatencyHistogram e2e;      // whole generate call
+};
+
+// One scrape row per (model, phase) pair for the latency table function.
+struct LatencyRow {
+    std::string model;
+    std::string metric;
+    uint64_t count;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+
 struct PerformanceMetrics {
     std::atomic<uint64_t> total_requests{0};
     std::atomic<uint64_t> total_tokens_generated{0};
@@ -103,7 +180,18 @@ struct ContextPoolEntry {
     std::chrono::steady_clock::time_point last_used;
     bool in_use;
     uint64_t usage_count;
-    
+    // Context size this entry was created with and the pool free list it
+    // returns to on release.
+    uint32_t n_ctx;
+    size_t size_class;
+    // Tokens currently held in sequence 0 of this context's KV cache. Lets a
+    // reused context keep the common prompt prefix warm (e.g. a shared system
+    // prompt) and only decode the per-request suffix.
+    std::vector<int32_t> kv_tokens;
+    // Hash of the GenerationParams the current sampler chain was compiled
+    // for; ConfigureSampler rebuilds the chain only when this changes.
+    uint64_t sampler_params_hash = 0;
+
     ContextPoolEntry();
     ~ContextPoolEntry();
 };
@@ -116,25 +204,88 @@ struct StreamToken {
     int token_id;
 };
 
+// Single-producer single-consumer ring buffer carrying tokens from the
+// generation thread to the reader without locks. Token pieces are stored
+// inline in the slot (they are almost always a handful of bytes) and only
+// spill to the heap for oversized pieces. The producer fills a slot and
+// publishes it by advancing head_ with release ordering; the consumer
+// observes it with acquire ordering, so each slot is owned by exactly one
+// side at any time and no mutex or condition variable is needed.
+class TokenRing {
+public:
+    static constexpr size_t kCapacity = 1024;   // slots, power of two
+    static constexpr size_t kInlineSize = 47;   // inline piece bytes per slot
+
+    TokenRing() = default;
+    ~TokenRing();
+    TokenRing(const TokenRing&) = delete;
+    TokenRing& operator=(const TokenRing&) = delete;
+
+    bool Push(const StreamToken& token);  // producer thread only
+    bool Pop(StreamToken& token);         // consumer thread only
+    bool Empty() const;
+
+private:
+    struct Slot {
+        char inline_text[kInlineSize + 1];
+        char* heap_text = nullptr;  // set when the piece exceeds kInlineSize
+        uint32_t length = 0;
+        float probability = 0.0f;
+        int32_t token_id = -1;
+        bool is_final = false;
+    };
+
+    Slot slots_[kCapacity];
+    alignas(64) std::atomic<size_t> head_{0};  // next slot the producer writes
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot the consumer reads
+};
+
+struct LoadedModel;
+
+// A streaming generation multiplexed onto the manager's fixed-size stream
+// executor. Instead of owning a thread, the session is a state machine:
+// workers call RunSlice() repeatedly, each call advancing the generation by
+// a bounded amount before yielding the worker to other sessions.
 struct StreamingSession {
     std::string session_id;
     std::string model_name;
     std::string prompt;
     GenerationParams params;
-    std::queue<StreamToken> token_queue;
-    std::mutex queue_mutex;
-    std::condition_variable queue_cv;
+    TokenRing token_ring;
     std::atomic<bool> finished{false};
     std::atomic<bool> error{false};
     std::string error_message;
-    std::thread generation_thread;
-    
+
     StreamingSession(const std::string& id, const std::string& model, const std::string& prompt, const GenerationParams& params);
     ~StreamingSession();
-    
-    void StartGeneration();
+
+    // Advances the generation by at most one prefill or kSliceTokens decode
+    // steps. Returns true while the session needs to be rescheduled; a
+    // session that cannot progress right now (no free context, full ring)
+    // backs off briefly and asks to be rescheduled rather than blocking.
+    bool RunSlice();
     bool GetNextToken(StreamToken& token);
+    // Non-blocking variant: false when no token is queued right now.
+    bool TryGetNextToken(StreamToken& token);
     void Stop();
+
+private:
+    // Decode at most this many tokens per slice before yielding the worker.
+    static constexpr int kSliceTokens = 16;
+
+    // State carried between slices; only the single worker currently
+    // running the session touches it.
+    std::shared_ptr<LoadedModel> model_ref_;
+    std::unique_ptr<ContextPoolEntry> context_entry_;
+    const llama_vocab* vocab_ = nullptr;
+    int n_generated_ = 0;
+    bool started_ = false;
+    bool prompt_evaluated_ = false;
+    bool final_pending_ = false;
+    std::chrono::steady_clock::time_point start_time_;
+
+    void FailSession(const std::string& message);
+    void ReleaseResources();
 };
 
 
@@ -154,12 +305,22 @@ struct BatchResult {
     std::string error_message;
     std::chrono::steady_clock::time_point completed_at;
     uint64_t processing_time_ms;
+    // Monotonic completion counter; pollers pass the highest sequence they
+    // have seen to fetch only newer results.
+    uint64_t sequence = 0;
 };
 
 class ContextPool {
 private:
-    std::queue<ContextPoolEntry*> available_contexts_;  
-    std::vector<std::unique_ptr<ContextPoolEntry>> all_contexts_;
+    // One LIFO free list per context size class: class 0 holds small
+    // contexts (quarter of the configured n_ctx) for short requests, the
+    // last class holds full-size contexts. Acquire pops the best-fitting
+    // free list in O(1); handed-out entries are owned by the caller until
+    // released, so no all-contexts bookkeeping scan is needed.
+    static constexpr size_t kNumSizeClasses = 2;
+    std::vector<std::unique_ptr<ContextPoolEntry>> free_lists_[kNumSizeClasses];
+    size_t total_contexts_ = 0;  // free + currently handed out
+    size_t kv_bytes_ = 0;        // estimated KV bytes of live contexts
     mutable std::mutex pool_mutex_;
     llama_model* model_;
     ModelConfig config_;
@@ -169,28 +330,53 @@ private:
 public:
     ContextPool(llama_model* model, const ModelConfig& config, size_t max_size = 4);
     ~ContextPool();
-    
-    
-    std::unique_ptr<ContextPoolEntry> AcquireContext();
+
+    // min_ctx_tokens is an upper bound on prompt + completion tokens; 0
+    // requests a full-size context (the conservative default).
+    std::unique_ptr<ContextPoolEntry> AcquireContext(size_t min_ctx_tokens = 0);
     void ReleaseContext(std::unique_ptr<ContextPoolEntry> entry);
     void CleanupExpiredContexts();
     size_t GetPoolSize() const;
+    size_t GetMaxPoolSize() const;
     size_t GetAvailableCount() const;
-    
+    // Estimated KV-cache bytes of all live contexts (free and handed out).
+    size_t GetKVBytes() const;
+
 private:
-    std::unique_ptr<ContextPoolEntry> CreateNewContext();
+    size_t EstimateKVBytesPerToken() const;
+    size_t ClassForRequest(size_t min_ctx_tokens) const;
+    uint32_t ClassCtxSize(size_t size_class) const;
+    std::unique_ptr<ContextPoolEntry> CreateNewContext(size_t size_class);
 };
 
 
+// Lifecycle of a models_ map entry. LoadModel inserts a Loading placeholder
+// and returns; a worker thread flips it to Ready (or Failed) when
+// llama_model_load_from_file finishes.
+enum class ModelLoadState {
+    Loading,
+    Ready,
+    Failed
+};
+
 struct LoadedModel {
     llama_model* model;
+    // Optional draft model for speculative decoding; nullptr when unused.
+    llama_model* draft_model;
     std::unique_ptr<ContextPool> context_pool;
+    std::unique_ptr<ContextPool> draft_pool;
     ModelConfig config;
+    std::atomic<ModelLoadState> load_state;
+    std::string load_error;
+    // Identifies the load that owns this entry, so a worker whose model was
+    // unloaded (and possibly reloaded) mid-load does not populate a stranger.
+    uint64_t load_id;
     std::chrono::steady_clock::time_point load_time;
-    std::chrono::steady_clock::time_point last_access;
+    // Written by GetModel under a shared lock, hence atomic.
+    std::atomic<std::chrono::steady_clock::time_point> last_access;
     std::atomic<size_t> reference_count;
     std::atomic<size_t> memory_usage_bytes;
-    
+
     LoadedModel();
     ~LoadedModel();
 };
@@ -199,11 +385,23 @@ struct LoadedModel {
 class SimpleModelManager {
 private:
     std::unordered_map<std::string, std::unique_ptr<LoadedModel>> models_;
-    mutable std::mutex models_mutex_;
+    // Read-mostly: every inference takes this shared just to look up its
+    // model and bump the atomic refcount; only load completion and unload
+    // take it exclusive to mutate the map.
+    mutable std::shared_mutex models_mutex_;
+    // Signalled whenever a load finishes, so GetModel can wait for an
+    // in-flight load instead of failing.
+    std::condition_variable_any models_cv_;
+    std::vector<std::thread> load_threads_;
+    std::mutex load_threads_mutex_;
     bool backend_initialized_;
     
     
     PerformanceMetrics metrics_;
+    // Per-model histograms; the mutex only guards map insertion, recording
+    // itself is atomic. unique_ptr keeps histogram addresses stable.
+    std::unordered_map<std::string, std::unique_ptr<ModelLatencyMetrics>> latency_metrics_;
+    mutable std::mutex latency_metrics_mutex_;
     std::chrono::steady_clock::time_point start_time_;
     
     
@@ -218,12 +416,84 @@ private:
     std::mutex batch_mutex_;
     std::condition_variable batch_cv_;
     std::thread batch_processor_;
+    std::atomic<bool> should_stop_batch_;
+    // Bounded result store: entries leave on first retrieval, when the TTL
+    // expires, or when the byte budget overflows (oldest first). The list
+    // tracks completion order for eviction; ids already retrieved leave
+    // stale list nodes that eviction skips.
     std::unordered_map<std::string, BatchResult> batch_results_;
+    std::list<std::string> batch_result_order_;
+    size_t batch_results_bytes_ = 0;
+    uint64_t batch_result_seq_ = 0;
+    static constexpr size_t kBatchResultsMaxBytes = 64 * 1024 * 1024;
+    static constexpr std::chrono::minutes kBatchResultTTL{10};
     
     
     std::unordered_map<std::string, std::shared_ptr<StreamingSession>> streaming_sessions_;
     mutable std::mutex streaming_mutex_;
-    
+
+    // Fixed-size stream executor: all sessions share these workers via a
+    // ready queue, so session count is no longer bounded by thread count.
+    std::vector<std::thread> stream_workers_;
+    std::deque<std::shared_ptr<StreamingSession>> stream_ready_;
+    std::mutex stream_queue_mutex_;
+    std::condition_variable stream_queue_cv_;
+    bool stream_workers_started_ = false;
+    std::atomic<bool> should_stop_stream_workers_{false};
+
+
+    // LRU tokenization cache. SQL scans push thousands of rows through the
+    // same prompt template, so identical prompts should only hit
+    // llama_tokenize once. Exact full-prompt hits only: byte-level BPE makes
+    // tokenize(prefix) + tokenize(suffix) differ from tokenize(prompt) at the
+    // seam, so stitched reuse would make output depend on cache warmth.
+    // Entries keep the full prompt text to rule out hash collisions; the list
+    // front is most recently used.
+    struct CachedTokens {
+        std::string prompt;
+        const llama_vocab* vocab;
+        bool add_special;
+        std::vector<int32_t> tokens;
+    };
+    static constexpr size_t kTokenCacheMaxEntries = 256;
+    std::list<CachedTokens> token_cache_lru_;
+    std::unordered_map<uint64_t, std::list<CachedTokens>::iterator> token_cache_index_;
+    std::mutex token_cache_mutex_;
+
+    // Deterministic generation cache. With temperature <= 0 the response is
+    // a pure function of (model, prompt, params), so scans over columns with
+    // heavy value repetition collapse to one inference per distinct value.
+    // Entries keep the full key material to rule out hash collisions; LRU
+    // with a byte budget, consulted before any context is acquired.
+    struct CachedGeneration {
+        uint64_t key;
+        std::string model;
+        std::string prompt;
+        uint64_t params_hash;
+        std::string response;
+    };
+    std::list<CachedGeneration> gen_cache_lru_;
+    std::unordered_map<uint64_t, std::list<CachedGeneration>::iterator> gen_cache_index_;
+    size_t gen_cache_bytes_ = 0;
+    size_t gen_cache_max_bytes_ = 32 * 1024 * 1024;
+    std::mutex gen_cache_mutex_;
+
+    // Per-model cache of the last formatted conversation prefix. Multi-turn
+    // chats resend the whole history each call; when the new history starts
+    // with the cached messages, only the suffix goes through the chat
+    // template again. Only trusted once the model's template is verified to
+    // render split histories identically to a whole-conversation render.
+    struct ChatPrefixCache {
+        uint64_t hash = 0;
+        size_t message_count = 0;
+        std::string formatted;
+        // 0 = unverified, 1 = split render matches whole render,
+        // -1 = stateful template, cache disabled for this model.
+        int splittable = 0;
+    };
+    std::unordered_map<std::string, ChatPrefixCache> chat_prefix_cache_;
+    std::mutex chat_prefix_mutex_;
+
 public:
     static SimpleModelManager& GetInstance();
     
@@ -238,33 +508,45 @@ public:
     
     
     bool IsModelLoaded(const std::string& model_name) const;
+    std::string GetModelLoadStatus(const std::string& model_name) const;
     size_t GetLoadedModelCount() const;
     std::vector<std::string> GetModelNames() const;
     std::vector<std::string> GetLoadedModelNames() const;
     
     
     std::string Generate(const std::string& model_name, const std::string& prompt, const GenerationParams& params);
+    std::vector<int32_t> TokenizeWithCache(const llama_vocab* vocab, const std::string& prompt, bool add_special);
     std::string ChatCompletion(const std::string& model_name, const std::vector<ChatMessage>& messages, const GenerationParams& params);
     std::vector<float> GetEmbeddings(const std::string& model_name, const std::string& text);
+    std::vector<std::vector<float>> GetEmbeddingsBatch(const std::string& model_name, const std::vector<std::string>& texts);
     
     
     std::string SubmitBatchRequest(const std::string& model_name, const std::string& prompt, const GenerationParams& params);
+    // Moves the result out of the store; a second call for the same id
+    // reports "Request not found".
     BatchResult GetBatchResult(const std::string& request_id);
-    std::vector<BatchResult> GetAllBatchResults();
+    // Moves out every result completed after `cursor` and advances
+    // `next_cursor` to the newest completion sequence.
+    std::vector<BatchResult> GetBatchResultsSince(uint64_t cursor, uint64_t& next_cursor);
     
     
     std::string StartStreamingSession(const std::string& model_name, const std::string& prompt, const GenerationParams& params);
     bool GetNextStreamToken(const std::string& session_id, StreamToken& token);
+    bool TryGetNextStreamToken(const std::string& session_id, StreamToken& token);
     void StopStreamingSession(const std::string& session_id);
     void CleanupExpiredSessions();
     
     
     PerformanceSnapshot GetMetrics() const;
+    ModelLatencyMetrics& GetLatencyMetrics(const std::string& model_name);
+    std::vector<LatencyRow> GetLatencySnapshot() const;
     void ResetMetrics();
     void Cleanup();
-    void ConfigureSampler(llama_sampler* sampler, const GenerationParams& params);
+    void ConfigureSampler(ContextPoolEntry* entry, const GenerationParams& params);
     std::string GetStatus() const;
     void SetMemoryLimit(size_t limit_mb);
+    // 0 disables the deterministic generation cache and drops its entries.
+    void SetGenerationCacheBudget(size_t limit_mb);
     bool CheckMemoryHealth() const;
     bool CheckMemoryLimit() const;
     size_t GetTotalMemoryUsage() const;
@@ -272,16 +554,32 @@ public:
     void ReleaseModelReference(const std::string& model_name);
     
     
-    std::vector<std::pair<std::string, int>> GetGPUInfo();
+    std::vector<GPUDeviceInfo> GetGPUInfo();
     
 private:
     void StartBackgroundTasks();
     void StopBackgroundTasks();
     void CleanupTask();
+    bool EvictLRUModel();
+    void RecomputeMemoryMetric();
+    void LoadModelWorker(std::string model_name, ModelConfig config, uint64_t load_id);
     void BatchProcessingTask();
+    void StreamWorkerLoop();
+    void ScheduleStreamSession(std::shared_ptr<StreamingSession> session);
+    void ProcessBatchGroup(const std::string& model_name, std::vector<BatchRequest>& requests);
+    std::string GenerateSpeculative(const std::string& model_name, std::shared_ptr<LoadedModel> model, const std::string& prompt, const GenerationParams& params);
+    void StoreBatchResult(const BatchRequest& request, std::string response, bool success, const std::string& error_message);
+    // Caller holds batch_mutex_.
+    void EvictBatchResults();
     void BackgroundCleanupWorker();
     void UpdateMemoryUsage();
     std::string GenerateRequestId();
+    bool LookupGenerationCache(uint64_t key, const std::string& model_name,
+                               const std::string& prompt, uint64_t params_hash,
+                               std::string& response);
+    void StoreGenerationCache(uint64_t key, const std::string& model_name,
+                              const std::string& prompt, uint64_t params_hash,
+                              const std::string& response);
 };
 
 } 
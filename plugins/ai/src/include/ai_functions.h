@@ -11,6 +11,7 @@ void llama_list_models_function(duckdb_function_info info, duckdb_data_chunk inp
 void llama_download_model_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_load_model_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_load_model_for_embeddings_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_load_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_unload_model_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_list_loaded_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 
@@ -18,8 +19,12 @@ void llama_list_loaded_function(duckdb_function_info info, duckdb_data_chunk inp
 void llama_generate_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_chat_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_embed_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_embed_list_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_embed_i8_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_embed_bit_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_batch_process_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_get_batch_result_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_batch_results_since_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 
 
 void llama_stream_generate_bind(duckdb_bind_info info);
@@ -37,6 +42,15 @@ void llama_gpu_info_function(duckdb_function_info info, duckdb_data_chunk input,
 
 
 void llama_get_performance_metrics_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
+void llama_latency_metrics_bind(duckdb_bind_info info);
+void llama_latency_metrics_init(duckdb_init_info info);
+void llama_latency_metrics_function(duckdb_function_info info, duckdb_data_chunk output);
+void llama_trace_bind(duckdb_bind_info info);
+void llama_trace_init(duckdb_init_info info);
+void llama_trace_function(duckdb_function_info info, duckdb_data_chunk output);
+void llama_gguf_info_bind(duckdb_bind_info info);
+void llama_gguf_info_init(duckdb_init_info info);
+void llama_gguf_info_function(duckdb_function_info info, duckdb_data_chunk output);
 void llama_get_memory_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_get_context_pool_status_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
 void llama_cleanup_contexts_function(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output);
@@ -11,10 +11,21 @@ public:
         bool success = false;
         std::string error_message;
         size_t bytes_downloaded = 0;
+        // FNV-1a of the downloaded content, computed in the page-warming
+        // pass; 0 when the pass was skipped. Compare against a published
+        // digest to verify the transfer.
+        uint64_t content_hash = 0;
     };
 
     /**
-     * Download a file from a URL to a local path
+     * Download a file from a URL to a local path.
+     *
+     * Large files from servers that accept Range requests are fetched as
+     * fixed-size segments over parallel connections, written at their
+     * offsets into a preallocated .part file. A sidecar bitmap records
+     * finished segments, so an interrupted download resumes where it left
+     * off instead of restarting from zero.
+     *
      * @param url The URL to download from
      * @param output_path The local file path to save to
      * @return DownloadResult with success status, error message, and bytes downloaded
@@ -23,12 +34,25 @@ public:
 
 private:
 #ifdef _WIN32
-    static DownloadResult download_windows(const std::string& host, const std::string& path, 
+    static DownloadResult download_windows(const std::string& host, const std::string& path,
                                          int port, bool is_https, const std::filesystem::path& output_path);
 #else
-    static DownloadResult download_unix(const std::string& host, const std::string& path, 
+    static DownloadResult download_unix(const std::string& host, const std::string& path,
                                       int port, bool is_https, const std::filesystem::path& output_path);
+    // HEAD probe: fills in the body size and whether the server honours
+    // Range requests. False when the probe itself failed.
+    static bool probe_unix(const std::string& host, const std::string& path,
+                           int port, bool is_https, size_t& total_size, bool& accepts_ranges);
+    // Fetches [offset, offset+length) and pwrites it at `offset` in fd.
+    static bool fetch_range_unix(const std::string& host, const std::string& path,
+                                 int port, bool is_https, size_t offset, size_t length, int fd);
+    static DownloadResult download_ranged_unix(const std::string& host, const std::string& path,
+                                               int port, bool is_https,
+                                               const std::filesystem::path& output_path, size_t total_size);
+    // Faults the finished file into the page cache via mmap so the model
+    // load that follows reads warm memory, hashing the content on the way.
+    static uint64_t warm_and_hash(const std::filesystem::path& path);
 #endif
 };
 
-} 
+}
@@ -0,0 +1,93 @@
+#include "trace_ring.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Vendored identically into the ai, atlas, and cql2elm plugins; keep in
+ * sync. See trace_ring.h for the module overview. */
+
+/* Per-thread capacity; a power of two so the wrap is a mask. 4096 spans at
+ * 32 bytes is 128KB per recording thread. */
+#define TRACE_RING_CAPACITY 4096
+
+typedef struct trace_ring {
+    trace_ring_span_t slots[TRACE_RING_CAPACITY];
+    _Atomic uint64_t head; /* total spans ever written by this thread */
+    uint64_t thread_id;
+    struct trace_ring *next;
+} trace_ring_t;
+
+static _Atomic(trace_ring_t *) trace_ring_list = NULL;
+static _Thread_local trace_ring_t *trace_ring_mine = NULL;
+
+uint64_t trace_ring_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t trace_ring_thread_id(void) {
+#ifdef __linux__
+    return (uint64_t)syscall(SYS_gettid);
+#else
+    return (uint64_t)pthread_self();
+#endif
+}
+
+static trace_ring_t *trace_ring_get(void) {
+    trace_ring_t *ring = trace_ring_mine;
+    if (ring) return ring;
+    ring = (trace_ring_t *)calloc(1, sizeof(trace_ring_t));
+    if (!ring) return NULL;
+    ring->thread_id = trace_ring_thread_id();
+    /* Lock-free list push; rings are never unlinked, so ABA cannot occur. */
+    trace_ring_t *head = atomic_load(&trace_ring_list);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&trace_ring_list, &head, ring));
+    trace_ring_mine = ring;
+    return ring;
+}
+
+void trace_ring_record(const char *span, uint64_t start_ns) {
+    trace_ring_t *ring = trace_ring_get();
+    if (!ring) return;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    trace_ring_span_t *slot = &ring->slots[head & (TRACE_RING_CAPACITY - 1)];
+    slot->span = span;
+    slot->start_ns = start_ns;
+    slot->duration_ns = trace_ring_now_ns() - start_ns;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+trace_ring_span_t *trace_ring_snapshot(size_t *out_count) {
+    *out_count = 0;
+    size_t total = 0;
+    for (trace_ring_t *ring = atomic_load(&trace_ring_list); ring; ring = ring->next) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        total += head < TRACE_RING_CAPACITY ? (size_t)head : TRACE_RING_CAPACITY;
+    }
+    if (total == 0) return NULL;
+
+    trace_ring_span_t *spans = (trace_ring_span_t *)malloc(total * sizeof(trace_ring_span_t));
+    if (!spans) return NULL;
+
+    size_t n = 0;
+    for (trace_ring_t *ring = atomic_load(&trace_ring_list); ring && n < total; ring = ring->next) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t kept = head < TRACE_RING_CAPACITY ? head : TRACE_RING_CAPACITY;
+        for (uint64_t i = head - kept; i < head && n < total; i++) {
+            spans[n] = ring->slots[i & (TRACE_RING_CAPACITY - 1)];
+            spans[n].thread_id = ring->thread_id;
+            n++;
+        }
+    }
+    *out_count = n;
+    return spans;
+}
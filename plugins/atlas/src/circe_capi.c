@@ -12,6 +12,9 @@ DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info
     RegisterCirceSqlRenderTranslateFunction(connection);
     RegisterCirceGenerateAndTranslateFunction(connection);
     RegisterCirceCheckCohortFunction(connection);
+    RegisterCirceTraceFunction(connection);
+
+    StartCirceWarmup();
 
     return true;
 }
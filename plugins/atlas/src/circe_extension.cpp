@@ -9,18 +9,229 @@
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 #include <dlfcn.h>
 #include <openssl/opensslv.h>
-#include "duckdb/common/types/blob.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #ifdef CIRCE_EMBEDDED_NATIVE_LIB
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <cstdint>
+#include <cstdio>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 #include "circe_native_embedded.h" // provides unsigned char circe_native_blob[] and size_t circe_native_blob_len
 #endif
 
 namespace duckdb {
 
+// LRU memo cache for the pure SqlRender/SqlTranslate operations. OHDSI
+// workloads translate the same cohort SQL against the same dialect across
+// many queries, so a repeat is a map lookup instead of a multi-millisecond
+// trip into the Graal isolate. Keys keep the full inputs (no collision
+// risk); bounded by total bytes, least recently used evicted first.
+namespace {
+
+struct CirceCacheEntry {
+    std::string key;
+    std::string value;
+};
+
+std::mutex circe_cache_mutex;
+std::list<CirceCacheEntry> circe_cache_lru;
+std::unordered_map<std::string, std::list<CirceCacheEntry>::iterator> circe_cache_index;
+size_t circe_cache_bytes = 0;
+constexpr size_t CIRCE_CACHE_MAX_BYTES = 16 * 1024 * 1024;
+
+bool CirceCacheLookup(const std::string &key, std::string &value) {
+    std::lock_guard<std::mutex> lock(circe_cache_mutex);
+    auto it = circe_cache_index.find(key);
+    if (it == circe_cache_index.end()) {
+        return false;
+    }
+    circe_cache_lru.splice(circe_cache_lru.begin(), circe_cache_lru, it->second);
+    value = it->second->value;
+    return true;
+}
+
+void CirceCacheStore(const std::string &key, const std::string &value) {
+    size_t bytes = key.size() + value.size();
+    std::lock_guard<std::mutex> lock(circe_cache_mutex);
+    if (bytes > CIRCE_CACHE_MAX_BYTES || circe_cache_index.count(key)) {
+        return;
+    }
+    circe_cache_lru.push_front({key, value});
+    circe_cache_index[key] = circe_cache_lru.begin();
+    circe_cache_bytes += bytes;
+    while (circe_cache_bytes > CIRCE_CACHE_MAX_BYTES && !circe_cache_lru.empty()) {
+        auto &victim = circe_cache_lru.back();
+        circe_cache_bytes -= victim.key.size() + victim.value.size();
+        circe_cache_index.erase(victim.key);
+        circe_cache_lru.pop_back();
+    }
+}
+
+// '\x1f' (unit separator) does not occur in SQL or JSON inputs, so the
+// joined fields stay unambiguous.
+std::string CirceCacheKey(char op, const std::string &a, const std::string &b, const std::string &c = "") {
+    std::string key;
+    key.reserve(a.size() + b.size() + c.size() + 4);
+    key += op;
+    key += a;
+    key += '\x1f';
+    key += b;
+    key += '\x1f';
+    key += c;
+    return key;
+}
+
+// Base64 decoding for cohort expressions. Definitions arrive as 50-500KB
+// base64 blobs, so the per-row decode shows up on profiles; on x86-64 a
+// runtime AVX2 check enables a lookup-shuffle decoder (32 input chars to
+// 24 output bytes per step), with the table-driven loop covering the tail,
+// padding, and non-AVX2 hosts. The output buffer is thread-local and reused
+// across rows, so steady-state decoding allocates nothing.
+const signed char kBase64DecodeTable[256] = {
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,62, -1,-1,-1,63,
+    52,53,54,55, 56,57,58,59, 60,61,-1,-1, -1,-1,-1,-1,
+    -1, 0, 1, 2,  3, 4, 5, 6,  7, 8, 9,10, 11,12,13,14,
+    15,16,17,18, 19,20,21,22, 23,24,25,-1, -1,-1,-1,-1,
+    -1,26,27,28, 29,30,31,32, 33,34,35,36, 37,38,39,40,
+    41,42,43,44, 45,46,47,48, 49,50,51,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1
+};
+
+thread_local std::string circe_decode_buf;
+
+#if defined(__x86_64__)
+bool HasAVX2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+// Lookup-shuffle decoder after Mula/aklomp: validate and translate via nibble
+// LUTs, then pack four 6-bit values per triple with two multiply-adds. Each
+// 32-byte store carries 24 payload bytes, so the destination needs 8 bytes of
+// slack past the true output size. Stops at the first invalid character (the
+// scalar tail re-checks and reports it) and leaves the final, possibly padded
+// quartets to the caller.
+__attribute__((target("avx2")))
+size_t Base64DecodeBlocksAVX2(const unsigned char *src, size_t len, unsigned char *dst, size_t &consumed) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_0F = _mm256_set1_epi8(0x0F);
+    const __m256i mask_2F = _mm256_set1_epi8(0x2F);
+
+    size_t in = 0;
+    size_t out = 0;
+    while (len - in >= 45) {
+        __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + in));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi16(str, 4), mask_0F);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_0F);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+        __m256i eq_2F = _mm256_cmpeq_epi8(str, mask_2F);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2F, hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        __m256i merged = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + out), packed);
+        in += 32;
+        out += 24;
+    }
+    consumed = in;
+    return out;
+}
+#endif
+
+bool CirceBase64Decode(const char *input, size_t input_len, std::string &out) {
+    out.clear();
+    if (input_len == 0) {
+        return true;
+    }
+    if (input_len % 4 != 0) {
+        return false;
+    }
+    size_t cap = input_len / 4 * 3;
+    out.resize(cap + 8); // slack for the 32-byte vector store
+    auto *dst = reinterpret_cast<unsigned char *>(&out[0]);
+    const auto *src = reinterpret_cast<const unsigned char *>(input);
+    size_t in = 0;
+    size_t produced = 0;
+#if defined(__x86_64__)
+    if (HasAVX2()) {
+        size_t consumed = 0;
+        produced = Base64DecodeBlocksAVX2(src, input_len, dst, consumed);
+        in = consumed;
+    }
+#endif
+    for (; in < input_len; in += 4) {
+        signed char a = kBase64DecodeTable[src[in]];
+        signed char b = kBase64DecodeTable[src[in + 1]];
+        if (a < 0 || b < 0) {
+            return false;
+        }
+        bool pad3 = src[in + 2] == '=';
+        bool pad4 = src[in + 3] == '=';
+        if ((pad3 || pad4) && (in + 4 != input_len || (pad3 && !pad4))) {
+            return false;
+        }
+        signed char c = pad3 ? 0 : kBase64DecodeTable[src[in + 2]];
+        signed char d = pad4 ? 0 : kBase64DecodeTable[src[in + 3]];
+        if (c < 0 || d < 0) {
+            return false;
+        }
+        uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+        dst[produced++] = (triple >> 16) & 0xFF;
+        if (!pad3) dst[produced++] = (triple >> 8) & 0xFF;
+        if (!pad4) dst[produced++] = triple & 0xFF;
+    }
+    out.resize(produced); // shrink keeps capacity for the next row
+    return true;
+}
+
+} // namespace
+
 inline void CirceHelloScalarFun(DataChunk &args, ExpressionState &state, Vector &result) {
     auto &name_vector = args.data[0];
     UnaryExecutor::Execute<string_t, string_t>(name_vector, result, args.size(), [&](string_t name) {
@@ -42,6 +253,7 @@ using circe_sql_render_fn = char *(*)(graal_isolatethread_t *, char *sql_templat
 using circe_sql_translate_fn = char *(*)(graal_isolatethread_t *, char *sql, char *target_dialect);
 using circe_sql_render_translate_fn = char *(*)(graal_isolatethread_t *, char *sql_template, char *target_dialect, char *parameters_json);
 using circe_check_cohort_fn = char *(*)(graal_isolatethread_t *, char *expr_json);
+using circe_free_result_fn = void (*)(graal_isolatethread_t *, char *result);
 using graal_create_isolate_fn = int (*)(void *params, graal_isolate_t **isolate, graal_isolatethread_t **thread);
 using graal_attach_thread_fn = int (*)(graal_isolate_t *isolate, graal_isolatethread_t **thread);
 using graal_detach_thread_fn = int (*)(graal_isolatethread_t *thread);
@@ -50,6 +262,7 @@ static circe_sql_render_fn circe_sql_render = nullptr;
 static circe_sql_translate_fn circe_sql_translate = nullptr;
 static circe_sql_render_translate_fn circe_sql_render_translate = nullptr;
 static circe_check_cohort_fn circe_check_cohort = nullptr;
+static circe_free_result_fn circe_free_result = nullptr;
 static graal_create_isolate_fn graal_create_isolate_ptr = nullptr;
 static graal_attach_thread_fn graal_attach_thread_ptr = nullptr;
 static graal_detach_thread_fn graal_detach_thread_ptr = nullptr;
@@ -79,28 +292,76 @@ static graal_isolatethread_t* GetCirceThread() {
 }
 
 #ifdef CIRCE_EMBEDDED_NATIVE_LIB
+static bool WriteAllBytes(int fd, const unsigned char *ptr, size_t remaining) {
+    while (remaining > 0) {
+        ssize_t w = write(fd, ptr, remaining);
+        if (w <= 0) return false;
+        ptr += w;
+        remaining -= w;
+    }
+    return true;
+}
+
+// FNV-1a over the embedded blob: names the on-disk cache file so a rebuilt
+// library gets a fresh path while identical builds share one extraction.
+static uint64_t CirceBlobHash() {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < circe_native_blob_len; i++) {
+        hash ^= circe_native_blob[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 static void *LoadEmbeddedCirceLibrary() {
     if (!circe_native_blob || circe_native_blob_len == 0) return nullptr;
+
+#ifdef __linux__
+    // Preferred path: an anonymous in-memory file. The .so never touches
+    // disk, so there is no write-out or fsync stall on slow /tmp.
+    int mfd = memfd_create("circe-native", MFD_CLOEXEC);
+    if (mfd >= 0) {
+        if (WriteAllBytes(mfd, circe_native_blob, circe_native_blob_len)) {
+            char fd_path[64];
+            snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", mfd);
+            void *handle = dlopen(fd_path, RTLD_LAZY | RTLD_LOCAL);
+            close(mfd);
+            if (handle) return handle;
+        } else {
+            close(mfd);
+        }
+    }
+#endif
+
+    // Fallback: extraction cached under a content-hash name, so subsequent
+    // process starts dlopen the existing file instead of rewriting the blob.
+    char cache_path[128];
+    snprintf(cache_path, sizeof(cache_path), "/tmp/circe-native-%016llx.so",
+             (unsigned long long)CirceBlobHash());
+    void *handle = dlopen(cache_path, RTLD_LAZY | RTLD_LOCAL);
+    if (handle) return handle;
+
     char tmpl[] = "/tmp/circe-native-XXXXXX.so";
     int fd = mkstemps(tmpl, 3);
     if (fd < 0) return nullptr;
-    size_t remaining = circe_native_blob_len;
-    const unsigned char *ptr = circe_native_blob;
-    while (remaining > 0) {
-        ssize_t w = write(fd, ptr, remaining);
-        if (w <= 0) { close(fd); unlink(tmpl); return nullptr; }
-        ptr += w; remaining -= w;
+    if (!WriteAllBytes(fd, circe_native_blob, circe_native_blob_len)) {
+        close(fd);
+        unlink(tmpl);
+        return nullptr;
     }
     fsync(fd);
-    void *handle = dlopen(tmpl, RTLD_LAZY | RTLD_LOCAL);
-    unlink(tmpl);
     close(fd);
-    return handle;
+    if (rename(tmpl, cache_path) != 0) {
+        // Lost a race (or /tmp is odd); load the temp file directly.
+        handle = dlopen(tmpl, RTLD_LAZY | RTLD_LOCAL);
+        unlink(tmpl);
+        return handle;
+    }
+    return dlopen(cache_path, RTLD_LAZY | RTLD_LOCAL);
 }
 #endif
 
-static void EnsureCirceLoaded() {
-    if (circe_convert) return;
+static void LoadCirceNative() {
 #ifdef CIRCE_EMBEDDED_NATIVE_LIB
     circe_lib_handle = LoadEmbeddedCirceLibrary();
 #endif
@@ -135,6 +396,8 @@ static void EnsureCirceLoaded() {
     if (!sym_render_translate) throw IOException("circe_sql_render_translate: symbol not found");
     auto sym_check = dlsym(circe_lib_handle, "circe_check_cohort");
     if (!sym_check) throw IOException("circe_check_cohort: symbol not found");
+    auto sym_free = dlsym(circe_lib_handle, "circe_free_result");
+    // circe_free_result is optional - older native libs keep results on the isolate heap
     auto sym_create = dlsym(circe_lib_handle, "graal_create_isolate");
     if (!sym_create) throw IOException("circe: graal_create_isolate symbol not found");
     auto sym_attach = dlsym(circe_lib_handle, "graal_attach_thread");
@@ -146,6 +409,7 @@ static void EnsureCirceLoaded() {
     circe_sql_translate = reinterpret_cast<circe_sql_translate_fn>(sym_translate);
     circe_sql_render_translate = reinterpret_cast<circe_sql_render_translate_fn>(sym_render_translate);
     circe_check_cohort = reinterpret_cast<circe_check_cohort_fn>(sym_check);
+    circe_free_result = sym_free ? reinterpret_cast<circe_free_result_fn>(sym_free) : nullptr;
     graal_create_isolate_ptr = reinterpret_cast<graal_create_isolate_fn>(sym_create);
     graal_attach_thread_ptr = sym_attach ? reinterpret_cast<graal_attach_thread_fn>(sym_attach) : nullptr;
     graal_detach_thread_ptr = sym_detach ? reinterpret_cast<graal_detach_thread_fn>(sym_detach) : nullptr;
@@ -153,21 +417,90 @@ static void EnsureCirceLoaded() {
     if (rc != 0 || !circe_thread) throw IOException("circe: failed to create Graal isolate (rc=" + std::to_string(rc) + ")");
 }
 
+static std::once_flag circe_load_flag;
+
+// call_once serializes concurrent first calls on the function-pointer setup
+// and leaves the flag unset when the loader throws, so a failed load is
+// retried (and reported) by the next call.
+static void EnsureCirceLoaded() {
+    std::call_once(circe_load_flag, LoadCirceNative);
+}
+
+// Opt-in eager warmup (CIRCE_EAGER_INIT=1): dlopen of the native image plus
+// graal_create_isolate costs seconds, and by default the first cohort query
+// pays it inside execution. With warmup enabled the load runs on a background
+// thread at extension load time. CIRCE_EAGER_INIT_THREADS additionally
+// pre-attaches that many isolate threads (attach, then detach), priming the
+// isolate's per-thread setup so the first wave of query threads attaches at
+// steady-state cost.
+static void StartCirceWarmup() {
+    const char *eager = std::getenv("CIRCE_EAGER_INIT");
+    if (!eager || *eager == '\0' || *eager == '0') {
+        return;
+    }
+    int attach_count = 0;
+    if (const char *threads = std::getenv("CIRCE_EAGER_INIT_THREADS")) {
+        attach_count = std::atoi(threads);
+    }
+    std::thread([attach_count]() {
+        try {
+            EnsureCirceLoaded();
+        } catch (std::exception &ex) {
+            // Best-effort: the lazy path reports the failure with query
+            // context when circe is actually used.
+            fprintf(stderr, "circe: eager init failed: %s\n", ex.what());
+            return;
+        }
+        for (int i = 0; i < attach_count; i++) {
+            std::thread([]() {
+                if (!graal_attach_thread_ptr || !circe_isolate) return;
+                graal_isolatethread_t *thread = nullptr;
+                if (graal_attach_thread_ptr(circe_isolate, &thread) == 0 && thread && graal_detach_thread_ptr) {
+                    graal_detach_thread_ptr(thread);
+                }
+            }).join();
+        }
+    }).detach();
+}
+
+// Copies a Graal-returned buffer into an engine-owned string and releases the
+// isolate-side allocation. Cohort SQL strings run to hundreds of kilobytes, so
+// without the release every call grows the isolate heap for the life of the
+// process. When the library predates circe_free_result the copy still happens
+// and the original leaks exactly as before - no worse than the old behavior.
+static std::string TakeCirceResult(graal_isolatethread_t *thread, char *raw) {
+    std::string out(raw);
+    if (circe_free_result) {
+        circe_free_result(thread, raw);
+    }
+    return out;
+}
+
 inline void CirceJsonBase64ToSqlScalar(DataChunk &args, ExpressionState &state, Vector &result) {
     EnsureCirceLoaded();
     auto &b64_vec = args.data[0];
     auto &opt_vec = args.data[1];
+    // Chunk-level dedup: joins duplicate the same cohort JSON across many
+    // rows (and options is usually a constant), so each distinct input pair
+    // crosses the Graal boundary once per chunk.
+    std::unordered_map<std::string, std::string> chunk_memo;
     BinaryExecutor::Execute<string_t, string_t, string_t>(b64_vec, opt_vec, result, args.size(), [&](string_t b64_expr, string_t opts) {
-        std::string decoded;
-        try {
-            decoded = duckdb::Blob::FromBase64(b64_expr);
-        } catch (std::exception &ex) {
-            throw IOException("circe_json_to_sql: base64 decode failed: " + std::string(ex.what()));
+        std::string key = CirceCacheKey('b', b64_expr.GetString(), opts.GetString());
+        auto memo_it = chunk_memo.find(key);
+        if (memo_it != chunk_memo.end()) {
+            return StringVector::AddString(result, memo_it->second);
+        }
+        if (!CirceBase64Decode(b64_expr.GetData(), b64_expr.GetSize(), circe_decode_buf)) {
+            throw IOException("circe_json_to_sql: base64 decode failed");
         }
-        if (decoded.empty()) throw IOException("circe_json_to_sql: decoded JSON empty");
-        char *sql_c = circe_convert(GetCirceThread(), const_cast<char *>(decoded.c_str()), const_cast<char *>(opts.GetData()));
+        if (circe_decode_buf.empty()) throw IOException("circe_json_to_sql: decoded JSON empty");
+        auto *thread = GetCirceThread();
+        char *sql_c = circe_convert(thread, const_cast<char *>(circe_decode_buf.c_str()), const_cast<char *>(opts.GetData()));
         if (!sql_c) throw IOException("circe_json_to_sql: native function returned null");
-        return StringVector::AddString(result, sql_c);
+        std::string sql = TakeCirceResult(thread, sql_c);
+        auto out = StringVector::AddString(result, sql);
+        chunk_memo.emplace(std::move(key), std::move(sql));
+        return out;
     });
 }
 
@@ -175,12 +508,22 @@ inline void CirceSqlRenderScalar(DataChunk &args, ExpressionState &state, Vector
     EnsureCirceLoaded();
     auto &template_vec = args.data[0];
     auto &params_vec = args.data[1];
+    std::unordered_map<std::string, std::string> chunk_memo;
     BinaryExecutor::Execute<string_t, string_t, string_t>(template_vec, params_vec, result, args.size(), [&](string_t sql_template, string_t params_json) {
         std::string template_str = sql_template.GetString();
         std::string params_str = params_json.GetString();
-        char *rendered_c = circe_sql_render(GetCirceThread(), const_cast<char *>(template_str.c_str()), const_cast<char *>(params_str.c_str()));
+        std::string key = CirceCacheKey('r', template_str, params_str);
+        auto memo_it = chunk_memo.find(key);
+        if (memo_it != chunk_memo.end()) {
+            return StringVector::AddString(result, memo_it->second);
+        }
+        auto *thread = GetCirceThread();
+        char *rendered_c = circe_sql_render(thread, const_cast<char *>(template_str.c_str()), const_cast<char *>(params_str.c_str()));
         if (!rendered_c) throw IOException("circe_sql_render: native function returned null");
-        return StringVector::AddString(result, rendered_c);
+        std::string rendered = TakeCirceResult(thread, rendered_c);
+        auto out = StringVector::AddString(result, rendered);
+        chunk_memo.emplace(std::move(key), std::move(rendered));
+        return out;
     });
 }
 
@@ -188,12 +531,29 @@ inline void CirceSqlTranslateScalar(DataChunk &args, ExpressionState &state, Vec
     EnsureCirceLoaded();
     auto &sql_vec = args.data[0];
     auto &dialect_vec = args.data[1];
+    std::unordered_map<std::string, std::string> chunk_memo;
     BinaryExecutor::Execute<string_t, string_t, string_t>(sql_vec, dialect_vec, result, args.size(), [&](string_t sql, string_t target_dialect) {
         std::string sql_str = sql.GetString();
         std::string dialect_str = target_dialect.GetString();
-        char *translated_c = circe_sql_translate(GetCirceThread(), const_cast<char *>(sql_str.c_str()), const_cast<char *>(dialect_str.c_str()));
+        std::string key = CirceCacheKey('t', sql_str, dialect_str);
+        auto memo_it = chunk_memo.find(key);
+        if (memo_it != chunk_memo.end()) {
+            return StringVector::AddString(result, memo_it->second);
+        }
+        std::string cached;
+        if (CirceCacheLookup(key, cached)) {
+            auto out = StringVector::AddString(result, cached);
+            chunk_memo.emplace(std::move(key), std::move(cached));
+            return out;
+        }
+        auto *thread = GetCirceThread();
+        char *translated_c = circe_sql_translate(thread, const_cast<char *>(sql_str.c_str()), const_cast<char *>(dialect_str.c_str()));
         if (!translated_c) throw IOException("circe_sql_translate: native function returned null");
-        return StringVector::AddString(result, translated_c);
+        std::string translated = TakeCirceResult(thread, translated_c);
+        CirceCacheStore(key, translated);
+        auto out = StringVector::AddString(result, translated);
+        chunk_memo.emplace(std::move(key), std::move(translated));
+        return out;
     });
 }
 
@@ -202,30 +562,54 @@ inline void CirceSqlRenderTranslateScalar(DataChunk &args, ExpressionState &stat
     auto &template_vec = args.data[0];
     auto &dialect_vec = args.data[1];
     auto &params_vec = args.data[2];
+    std::unordered_map<std::string, std::string> chunk_memo;
     TernaryExecutor::Execute<string_t, string_t, string_t, string_t>(template_vec, dialect_vec, params_vec, result, args.size(), [&](string_t sql_template, string_t target_dialect, string_t params_json) {
         std::string template_str = sql_template.GetString();
         std::string dialect_str = target_dialect.GetString();
         std::string params_str = params_json.GetString();
-        char *result_c = circe_sql_render_translate(GetCirceThread(), const_cast<char *>(template_str.c_str()), const_cast<char *>(dialect_str.c_str()), const_cast<char *>(params_str.c_str()));
+        std::string key = CirceCacheKey('x', template_str, dialect_str, params_str);
+        auto memo_it = chunk_memo.find(key);
+        if (memo_it != chunk_memo.end()) {
+            return StringVector::AddString(result, memo_it->second);
+        }
+        std::string cached;
+        if (CirceCacheLookup(key, cached)) {
+            auto out = StringVector::AddString(result, cached);
+            chunk_memo.emplace(std::move(key), std::move(cached));
+            return out;
+        }
+        auto *thread = GetCirceThread();
+        char *result_c = circe_sql_render_translate(thread, const_cast<char *>(template_str.c_str()), const_cast<char *>(dialect_str.c_str()), const_cast<char *>(params_str.c_str()));
         if (!result_c) throw IOException("circe_sql_render_translate: native function returned null");
-        return StringVector::AddString(result, result_c);
+        std::string rendered = TakeCirceResult(thread, result_c);
+        CirceCacheStore(key, rendered);
+        auto out = StringVector::AddString(result, rendered);
+        chunk_memo.emplace(std::move(key), std::move(rendered));
+        return out;
     });
 }
 
 inline void CirceCheckCohortScalar(DataChunk &args, ExpressionState &state, Vector &result) {
     EnsureCirceLoaded();
     auto &b64_vec = args.data[0];
+    std::unordered_map<std::string, std::string> chunk_memo;
     UnaryExecutor::Execute<string_t, string_t>(b64_vec, result, args.size(), [&](string_t b64_expr) {
-        std::string decoded;
-        try {
-            decoded = duckdb::Blob::FromBase64(b64_expr);
-        } catch (std::exception &ex) {
-            throw IOException("circe_check_cohort: base64 decode failed: " + std::string(ex.what()));
+        std::string key = b64_expr.GetString();
+        auto memo_it = chunk_memo.find(key);
+        if (memo_it != chunk_memo.end()) {
+            return StringVector::AddString(result, memo_it->second);
+        }
+        if (!CirceBase64Decode(b64_expr.GetData(), b64_expr.GetSize(), circe_decode_buf)) {
+            throw IOException("circe_check_cohort: base64 decode failed");
         }
-        if (decoded.empty()) throw IOException("circe_check_cohort: decoded JSON empty");
-        char *warnings_json = circe_check_cohort(GetCirceThread(), const_cast<char *>(decoded.c_str()));
+        if (circe_decode_buf.empty()) throw IOException("circe_check_cohort: decoded JSON empty");
+        auto *thread = GetCirceThread();
+        char *warnings_json = circe_check_cohort(thread, const_cast<char *>(circe_decode_buf.c_str()));
         if (!warnings_json) throw IOException("circe_check_cohort: native function returned null");
-        return StringVector::AddString(result, warnings_json);
+        std::string warnings = TakeCirceResult(thread, warnings_json);
+        auto out = StringVector::AddString(result, warnings);
+        chunk_memo.emplace(std::move(key), std::move(warnings));
+        return out;
     });
 }
 
@@ -237,6 +621,7 @@ static void LoadInternal(DatabaseInstance &instance) {
     ExtensionUtil::RegisterFunction(instance, ScalarFunction("circe_sql_translate", {LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::VARCHAR, CirceSqlTranslateScalar));
     ExtensionUtil::RegisterFunction(instance, ScalarFunction("circe_sql_render_translate", {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::VARCHAR, CirceSqlRenderTranslateScalar));
     ExtensionUtil::RegisterFunction(instance, ScalarFunction("circe_check_cohort", {LogicalType::VARCHAR}, LogicalType::VARCHAR, CirceCheckCohortScalar));
+    StartCirceWarmup();
 }
 
 void CirceExtension::Load(DuckDB &db) { LoadInternal(*db.instance); }
@@ -1,47 +1,37 @@
 #include "duckdb_extension.h"
 #include "circe_functions.h"
-#include <dlfcn.h>
+#include "graal_runtime.h"
+#include "trace_ring.h"
 #include <openssl/opensslv.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <pthread.h>
-#include <errno.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #ifdef CIRCE_EMBEDDED_NATIVE_LIB
-#include <unistd.h>
-#include <sys/stat.h>
-#include <fcntl.h>
 #include "circe_native_embedded.h"
 #endif
 
 #define CIRCE_WORKER_STACK_SIZE (16 * 1024 * 1024)
+#define CIRCE_WORKER_POOL_SIZE 4
 
 DUCKDB_EXTENSION_EXTERN
 
-typedef struct graal_isolate graal_isolate_t;
-typedef struct graal_isolatethread graal_isolatethread_t;
-
 typedef char *(*circe_convert_fn)(graal_isolatethread_t *, char *expr_json, char *options_json);
 typedef char *(*circe_sql_render_fn)(graal_isolatethread_t *, char *sql_template, char *parameters_json);
 typedef char *(*circe_sql_translate_fn)(graal_isolatethread_t *, char *sql, char *target_dialect);
 typedef char *(*circe_sql_render_translate_fn)(graal_isolatethread_t *, char *sql_template, char *target_dialect, char *parameters_json);
 typedef char *(*circe_check_cohort_fn)(graal_isolatethread_t *, char *expr_json);
-typedef int (*graal_create_isolate_fn)(void *params, graal_isolate_t **isolate, graal_isolatethread_t **thread);
-typedef int (*graal_attach_thread_fn)(graal_isolate_t *isolate, graal_isolatethread_t **thread);
-typedef int (*graal_detach_thread_fn)(graal_isolatethread_t *thread);
 
-static void *circe_lib_handle = NULL;
-static graal_isolate_t *circe_isolate = NULL;
-static graal_isolatethread_t *circe_thread = NULL;
+static graal_runtime_t circe_runtime;
 static circe_convert_fn circe_convert = NULL;
 static circe_sql_render_fn circe_sql_render = NULL;
 static circe_sql_translate_fn circe_sql_translate = NULL;
 static circe_sql_render_translate_fn circe_sql_render_translate = NULL;
 static circe_check_cohort_fn circe_check_cohort = NULL;
-static graal_create_isolate_fn graal_create_isolate_ptr = NULL;
-static graal_attach_thread_fn graal_attach_thread_ptr = NULL;
-static graal_detach_thread_fn graal_detach_thread_ptr = NULL;
 
 static pthread_once_t circe_init_once = PTHREAD_ONCE_INIT;
 static int circe_init_success = 0;
@@ -59,74 +49,254 @@ typedef struct {
     char* arg1;
     char* arg2;
     char* arg3;
-    char* result;
-} circe_work_t;
+} circe_op_args_t;
+
+/* Trace span names, indexed by circe_op_type. */
+static const char* const circe_trace_names[] = {
+    "build_cohort_sql", "sql_render", "sql_translate", "sql_render_translate", "check_cohort"
+};
 
-static char* circe_execute_op(graal_isolatethread_t* thread, circe_work_t* work) {
-    switch (work->op) {
+/* Op callback for the shared runtime: returns the raw Graal buffer, which the
+ * runtime copies into caller-owned malloc memory and releases on the worker
+ * thread that produced it. */
+static char* circe_execute_op(graal_isolatethread_t* thread, void* ctx) {
+    circe_op_args_t* args = (circe_op_args_t*)ctx;
+    uint64_t trace_start = trace_ring_now_ns();
+    char* raw;
+    switch (args->op) {
         case CIRCE_OP_BUILD_SQL:
-            return circe_convert(thread, work->arg1, work->arg2);
+            raw = circe_convert(thread, args->arg1, args->arg2);
+            break;
         case CIRCE_OP_SQL_RENDER:
-            return circe_sql_render(thread, work->arg1, work->arg2);
+            raw = circe_sql_render(thread, args->arg1, args->arg2);
+            break;
         case CIRCE_OP_SQL_TRANSLATE:
-            return circe_sql_translate(thread, work->arg1, work->arg2);
+            raw = circe_sql_translate(thread, args->arg1, args->arg2);
+            break;
         case CIRCE_OP_SQL_RENDER_TRANSLATE:
-            return circe_sql_render_translate(thread, work->arg1, work->arg2, work->arg3);
+            raw = circe_sql_render_translate(thread, args->arg1, args->arg2, args->arg3);
+            break;
         case CIRCE_OP_CHECK_COHORT:
-            return circe_check_cohort(thread, work->arg1);
+            raw = circe_check_cohort(thread, args->arg1);
+            break;
         default:
-            fprintf(stderr, "circe: unknown operation type %d\n", work->op);
+            fprintf(stderr, "circe: unknown operation type %d\n", args->op);
             return NULL;
     }
+    trace_ring_record(circe_trace_names[args->op], trace_start);
+    return raw;
 }
 
-static void* circe_worker_thread(void* arg) {
-    circe_work_t* work = (circe_work_t*)arg;
+// LRU memo cache for the pure translate/render_translate operations: the
+// same cohort SQL gets translated against the same dialect over and over, so
+// a repeat is a list walk and a memcpy instead of a trip through SqlRender
+// inside GraalVM. Keys keep the full inputs ('\x1f'-joined, no collision
+// risk); bounded by total bytes, least recently used evicted first.
+#define CIRCE_MEMO_MAX_BYTES (16 * 1024 * 1024)
+
+typedef struct circe_memo_entry {
+    char* key;
+    size_t key_len;
+    char* value;
+    struct circe_memo_entry* prev;
+    struct circe_memo_entry* next;
+} circe_memo_entry_t;
+
+static pthread_mutex_t circe_memo_mutex = PTHREAD_MUTEX_INITIALIZER;
+static circe_memo_entry_t* circe_memo_head = NULL;
+static circe_memo_entry_t* circe_memo_tail = NULL;
+static size_t circe_memo_bytes = 0;
+
+static char* circe_memo_make_key(circe_op_type op, const char* arg1, const char* arg2,
+                                 const char* arg3, size_t* out_len) {
+    size_t l1 = arg1 ? strlen(arg1) : 0;
+    size_t l2 = arg2 ? strlen(arg2) : 0;
+    size_t l3 = arg3 ? strlen(arg3) : 0;
+    size_t len = 1 + l1 + 1 + l2 + 1 + l3;
+    char* key = (char*)malloc(len);
+    if (!key) return NULL;
+    char* p = key;
+    *p++ = (char)('0' + op);
+    if (l1) { memcpy(p, arg1, l1); p += l1; }
+    *p++ = '\x1f';
+    if (l2) { memcpy(p, arg2, l2); p += l2; }
+    *p++ = '\x1f';
+    if (l3) { memcpy(p, arg3, l3); p += l3; }
+    *out_len = len;
+    return key;
+}
 
-    graal_isolatethread_t* thread = NULL;
-    if (graal_attach_thread_ptr(circe_isolate, &thread) != 0 || !thread) {
-        work->result = NULL;
-        return NULL;
-    }
+static void circe_memo_unlink(circe_memo_entry_t* entry) {
+    if (entry->prev) entry->prev->next = entry->next; else circe_memo_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev; else circe_memo_tail = entry->prev;
+    entry->prev = NULL;
+    entry->next = NULL;
+}
 
-    work->result = circe_execute_op(thread, work);
-    if (graal_detach_thread_ptr(thread) != 0) {
-        fprintf(stderr, "circe: graal_detach_thread failed\n");
+static void circe_memo_push_front(circe_memo_entry_t* entry) {
+    entry->next = circe_memo_head;
+    if (circe_memo_head) circe_memo_head->prev = entry;
+    circe_memo_head = entry;
+    if (!circe_memo_tail) circe_memo_tail = entry;
+}
+
+// Returns a malloc'd copy the caller owns, NULL on miss.
+static char* circe_memo_lookup(const char* key, size_t key_len) {
+    pthread_mutex_lock(&circe_memo_mutex);
+    for (circe_memo_entry_t* entry = circe_memo_head; entry; entry = entry->next) {
+        if (entry->key_len == key_len && memcmp(entry->key, key, key_len) == 0) {
+            if (entry != circe_memo_head) {
+                circe_memo_unlink(entry);
+                circe_memo_push_front(entry);
+            }
+            char* copy = strdup(entry->value);
+            pthread_mutex_unlock(&circe_memo_mutex);
+            return copy;
+        }
     }
+    pthread_mutex_unlock(&circe_memo_mutex);
     return NULL;
 }
 
-static char* circe_run_with_large_stack(circe_op_type op, char* arg1, char* arg2, char* arg3) {
-    circe_work_t work = {op, arg1, arg2, arg3, NULL};
-    pthread_t thread;
-    pthread_attr_t attr;
+static void circe_memo_store(const char* key, size_t key_len, const char* value) {
+    size_t value_len = strlen(value);
+    size_t bytes = key_len + value_len + sizeof(circe_memo_entry_t);
+    if (bytes > CIRCE_MEMO_MAX_BYTES) return;
+
+    circe_memo_entry_t* entry = (circe_memo_entry_t*)malloc(sizeof(circe_memo_entry_t));
+    if (!entry) return;
+    entry->key = (char*)malloc(key_len);
+    entry->value = strdup(value);
+    if (!entry->key || !entry->value) {
+        free(entry->key);
+        free(entry->value);
+        free(entry);
+        return;
+    }
+    memcpy(entry->key, key, key_len);
+    entry->key_len = key_len;
+    entry->prev = NULL;
+    entry->next = NULL;
+
+    pthread_mutex_lock(&circe_memo_mutex);
+    circe_memo_push_front(entry);
+    circe_memo_bytes += bytes;
+    while (circe_memo_bytes > CIRCE_MEMO_MAX_BYTES && circe_memo_tail && circe_memo_tail != circe_memo_head) {
+        circe_memo_entry_t* victim = circe_memo_tail;
+        circe_memo_unlink(victim);
+        circe_memo_bytes -= victim->key_len + strlen(victim->value) + sizeof(circe_memo_entry_t);
+        free(victim->key);
+        free(victim->value);
+        free(victim);
+    }
+    pthread_mutex_unlock(&circe_memo_mutex);
+}
 
-    if (pthread_attr_init(&attr) != 0) {
-        return circe_execute_op(circe_thread, &work);
+/* Result is always caller-owned malloc memory (memo hit or execute copy);
+ * call sites free() it after copying into the output vector. */
+static char* circe_run_op(circe_op_type op, char* arg1, char* arg2, char* arg3) {
+    circe_op_args_t args = {op, arg1, arg2, arg3};
+
+    char* key = NULL;
+    size_t key_len = 0;
+    if (op == CIRCE_OP_SQL_TRANSLATE || op == CIRCE_OP_SQL_RENDER_TRANSLATE) {
+        key = circe_memo_make_key(op, arg1, arg2, arg3, &key_len);
+        if (key) {
+            char* hit = circe_memo_lookup(key, key_len);
+            if (hit) {
+                free(key);
+                return hit;
+            }
+        }
     }
 
-    if (pthread_attr_setstacksize(&attr, CIRCE_WORKER_STACK_SIZE) != 0) {
-        pthread_attr_destroy(&attr);
-        return circe_execute_op(circe_thread, &work);
+    char* result = graal_runtime_run(&circe_runtime, circe_execute_op, &args);
+
+    if (key) {
+        if (result) {
+            circe_memo_store(key, key_len, result);
+        }
+        free(key);
     }
+    return result;
+}
 
-    if (pthread_create(&thread, &attr, circe_worker_thread, &work) != 0) {
-        pthread_attr_destroy(&attr);
-        return circe_execute_op(circe_thread, &work);
+// Per-chunk memo: Atlas workloads carry a handful of distinct cohorts across
+// thousands of rows, so within one 2048-row chunk most inputs are repeats.
+// Each scalar keeps one of these for the duration of a chunk - a repeat is a
+// linear probe over at most a chunk's worth of entries instead of a trip
+// through the Graal boundary (or even the global memo's mutex). Keys reuse
+// circe_memo_make_key; entries are dropped when the chunk ends.
+typedef struct {
+    char** keys;
+    size_t* key_lens;
+    char** values;
+    idx_t count;
+} circe_chunk_memo_t;
+
+static void circe_chunk_memo_init(circe_chunk_memo_t* memo, idx_t rows) {
+    memo->count = 0;
+    memo->keys = (char**)malloc(rows * sizeof(char*));
+    memo->key_lens = (size_t*)malloc(rows * sizeof(size_t));
+    memo->values = (char**)malloc(rows * sizeof(char*));
+    if (!memo->keys || !memo->key_lens || !memo->values) {
+        free(memo->keys);
+        free(memo->key_lens);
+        free(memo->values);
+        memo->keys = NULL;
+        memo->key_lens = NULL;
+        memo->values = NULL;
     }
+}
 
-    int rc;
-    while ((rc = pthread_join(thread, NULL)) == EINTR) {
+// Returns the memo's own copy (valid until destroy), NULL on miss.
+static const char* circe_chunk_memo_lookup(const circe_chunk_memo_t* memo, const char* key, size_t key_len) {
+    for (idx_t i = 0; i < memo->count; i++) {
+        if (memo->key_lens[i] == key_len && memcmp(memo->keys[i], key, key_len) == 0) {
+            return memo->values[i];
+        }
     }
-    pthread_attr_destroy(&attr);
-    return work.result;
+    return NULL;
+}
+
+// Copies key and value; at most one entry is added per row, so the arrays
+// sized at init never overflow. Allocation failure just skips the memo.
+static void circe_chunk_memo_remember(circe_chunk_memo_t* memo, const char* key, size_t key_len, const char* value) {
+    if (!memo->keys) return;
+    char* key_copy = (char*)malloc(key_len);
+    char* value_copy = strdup(value);
+    if (!key_copy || !value_copy) {
+        free(key_copy);
+        free(value_copy);
+        return;
+    }
+    memcpy(key_copy, key, key_len);
+    memo->keys[memo->count] = key_copy;
+    memo->key_lens[memo->count] = key_len;
+    memo->values[memo->count] = value_copy;
+    memo->count++;
 }
 
-static const char base64_decode_table[256] = {
+static void circe_chunk_memo_destroy(circe_chunk_memo_t* memo) {
+    for (idx_t i = 0; i < memo->count; i++) {
+        free(memo->keys[i]);
+        free(memo->values[i]);
+    }
+    free(memo->keys);
+    free(memo->key_lens);
+    free(memo->values);
+}
+
+// Base64 decoding for cohort expressions. Definitions arrive as 50-500KB
+// base64 blobs, so the per-row decode shows up on profiles; on x86-64 a
+// runtime AVX2 check enables a lookup-shuffle decoder (32 input chars to
+// 24 output bytes per step), with the table-driven loop covering the tail,
+// padding, invalid-character rejection, and non-AVX2 hosts.
+static const signed char base64_decode_table[256] = {
     -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
     -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
     -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,62, -1,-1,-1,63,
-    52,53,54,55, 56,57,58,59, 60,61,-1,-1, -1,-2,-1,-1,
+    52,53,54,55, 56,57,58,59, 60,61,-1,-1, -1,-1,-1,-1,
     -1, 0, 1, 2,  3, 4, 5, 6,  7, 8, 9,10, 11,12,13,14,
     15,16,17,18, 19,20,21,22, 23,24,25,-1, -1,-1,-1,-1,
     -1,26,27,28, 29,30,31,32, 33,34,35,36, 37,38,39,40,
@@ -141,100 +311,156 @@ static const char base64_decode_table[256] = {
     -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1
 };
 
-static char* base64_decode(const char* input, size_t input_len, size_t* output_len) {
-    if (input_len % 4 != 0) return NULL;
-    
-    size_t decoded_len = input_len / 4 * 3;
-    if (input_len > 0 && input[input_len - 1] == '=') decoded_len--;
-    if (input_len > 1 && input[input_len - 2] == '=') decoded_len--;
-    
-    char* decoded = (char*)duckdb_malloc(decoded_len + 1);
-    if (!decoded) return NULL;
-    
-    for (size_t i = 0, j = 0; i < input_len;) {
-        uint32_t sextet_a = input[i] == '=' ? (i++, 0) : base64_decode_table[(int)input[i++]];
-        uint32_t sextet_b = input[i] == '=' ? (i++, 0) : base64_decode_table[(int)input[i++]];
-        uint32_t sextet_c = input[i] == '=' ? (i++, 0) : base64_decode_table[(int)input[i++]];
-        uint32_t sextet_d = input[i] == '=' ? (i++, 0) : base64_decode_table[(int)input[i++]];
-
-        uint32_t triple = (sextet_a << 3 * 6) + (sextet_b << 2 * 6) + (sextet_c << 1 * 6) + (sextet_d << 0 * 6);
-
-        if (j < decoded_len) decoded[j++] = (triple >> 2 * 8) & 0xFF;
-        if (j < decoded_len) decoded[j++] = (triple >> 1 * 8) & 0xFF;
-        if (j < decoded_len) decoded[j++] = (triple >> 0 * 8) & 0xFF;
-    }
-    
-    decoded[decoded_len] = '\0';
-    *output_len = decoded_len;
-    return decoded;
+#if defined(__x86_64__)
+static int circe_has_avx2(void) {
+    static int has = -1;
+    if (has < 0) has = __builtin_cpu_supports("avx2");
+    return has;
 }
 
-#ifdef CIRCE_EMBEDDED_NATIVE_LIB
-static void *LoadEmbeddedCirceLibrary() {
-    if (!circe_native_blob || circe_native_blob_len == 0) return NULL;
-    char tmpl[] = "/tmp/circe-native-XXXXXX.so";
-    int fd = mkstemps(tmpl, 3);
-    if (fd < 0) return NULL;
-    size_t remaining = circe_native_blob_len;
-    const unsigned char *ptr = circe_native_blob;
-    while (remaining > 0) {
-        ssize_t w = write(fd, ptr, remaining);
-        if (w <= 0) { close(fd); unlink(tmpl); return NULL; }
-        ptr += w; remaining -= w;
-    }
-    fsync(fd);
-    void *handle = dlopen(tmpl, RTLD_LAZY | RTLD_LOCAL);
-    unlink(tmpl);
-    close(fd);
-    return handle;
+// Lookup-shuffle decoder after Mula/aklomp: validate and translate via nibble
+// LUTs, then pack four 6-bit values per triple with two multiply-adds. Each
+// 32-byte store carries 24 payload bytes, so the destination needs 8 bytes of
+// slack past the true output size. Stops at the first invalid character (the
+// scalar tail re-checks and reports it) and leaves the final, possibly padded
+// quartets to the caller.
+__attribute__((target("avx2")))
+static size_t base64_decode_blocks_avx2(const unsigned char* src, size_t len, unsigned char* dst, size_t* consumed) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_0F = _mm256_set1_epi8(0x0F);
+    const __m256i mask_2F = _mm256_set1_epi8(0x2F);
+
+    size_t in = 0;
+    size_t out = 0;
+    while (len - in >= 45) {
+        __m256i str = _mm256_loadu_si256((const __m256i*)(src + in));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi16(str, 4), mask_0F);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_0F);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+        __m256i eq_2F = _mm256_cmpeq_epi8(str, mask_2F);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2F, hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        __m256i merged = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+        _mm256_storeu_si256((__m256i*)(dst + out), packed);
+        in += 32;
+        out += 24;
+    }
+    *consumed = in;
+    return out;
 }
 #endif
 
-static void CirceInitOnce(void) {
-#ifdef CIRCE_EMBEDDED_NATIVE_LIB
-    circe_lib_handle = LoadEmbeddedCirceLibrary();
-#endif
+static char* base64_decode(const char* input, size_t input_len, size_t* output_len) {
+    uint64_t trace_start = trace_ring_now_ns();
+    if (input_len == 0 || input_len % 4 != 0) return NULL;
 
-    if (!circe_lib_handle) {
-        const char *candidates[] = {
-            "./circe-be/native-libs/libcirce-native-lib.so",
-            "./circe-be/native-libs/linux-x86_64/libcirce-native-lib.so",
-            "./circe-be/native-libs/libcirce-native.so",
-            "./circe-be/native-libs/linux-x86_64/libcirce-native.so",
-            "libcirce-native-lib.so",
-            "libcirce-native.so"
-        };
-        for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
-            circe_lib_handle = dlopen(candidates[i], RTLD_LAZY | RTLD_LOCAL);
-            if (circe_lib_handle) break;
+    // 8 bytes of slack past the true output size for the 32-byte vector store.
+    size_t cap = input_len / 4 * 3;
+    char* decoded = (char*)duckdb_malloc(cap + 8 + 1);
+    if (!decoded) return NULL;
+
+    const unsigned char* src = (const unsigned char*)input;
+    unsigned char* dst = (unsigned char*)decoded;
+    size_t in = 0;
+    size_t produced = 0;
+#if defined(__x86_64__)
+    if (circe_has_avx2()) {
+        size_t consumed = 0;
+        produced = base64_decode_blocks_avx2(src, input_len, dst, &consumed);
+        in = consumed;
+    }
+#endif
+    for (; in < input_len; in += 4) {
+        signed char a = base64_decode_table[src[in]];
+        signed char b = base64_decode_table[src[in + 1]];
+        if (a < 0 || b < 0) {
+            duckdb_free(decoded);
+            return NULL;
+        }
+        int pad3 = src[in + 2] == '=';
+        int pad4 = src[in + 3] == '=';
+        if ((pad3 || pad4) && (in + 4 != input_len || (pad3 && !pad4))) {
+            duckdb_free(decoded);
+            return NULL;
+        }
+        signed char c = pad3 ? 0 : base64_decode_table[src[in + 2]];
+        signed char d = pad4 ? 0 : base64_decode_table[src[in + 3]];
+        if (c < 0 || d < 0) {
+            duckdb_free(decoded);
+            return NULL;
         }
+        uint32_t triple = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | (uint32_t)d;
+        dst[produced++] = (triple >> 16) & 0xFF;
+        if (!pad3) dst[produced++] = (triple >> 8) & 0xFF;
+        if (!pad4) dst[produced++] = triple & 0xFF;
     }
 
-    if (!circe_lib_handle) return;
+    decoded[produced] = '\0';
+    *output_len = produced;
+    trace_ring_record("base64_decode", trace_start);
+    return decoded;
+}
 
-    void *sym_build = dlsym(circe_lib_handle, "circe_build_cohort_sql");
+static void CirceInitOnce(void) {
+    static const char *const candidates[] = {
+        "./circe-be/native-libs/libcirce-native-lib.so",
+        "./circe-be/native-libs/linux-x86_64/libcirce-native-lib.so",
+        "./circe-be/native-libs/libcirce-native.so",
+        "./circe-be/native-libs/linux-x86_64/libcirce-native.so",
+        "libcirce-native-lib.so",
+        "libcirce-native.so"
+    };
+    graal_runtime_config_t config = {
+        .name = "circe",
+#ifdef CIRCE_EMBEDDED_NATIVE_LIB
+        .embedded_blob = circe_native_blob,
+        .embedded_blob_len = circe_native_blob_len,
+#else
+        .embedded_blob = NULL,
+        .embedded_blob_len = 0,
+#endif
+        .candidates = candidates,
+        .candidate_count = sizeof(candidates) / sizeof(candidates[0]),
+        .free_result_symbol = "circe_free_result",
+        .worker_count = CIRCE_WORKER_POOL_SIZE,
+        .worker_stack_size = CIRCE_WORKER_STACK_SIZE
+    };
+    if (!graal_runtime_load(&circe_runtime, &config)) return;
+
+    void *sym_build = graal_runtime_sym(&circe_runtime, "circe_build_cohort_sql");
     if (!sym_build) return;
-    void *sym_render = dlsym(circe_lib_handle, "circe_sql_render");
+    void *sym_render = graal_runtime_sym(&circe_runtime, "circe_sql_render");
     if (!sym_render) return;
-    void *sym_translate = dlsym(circe_lib_handle, "circe_sql_translate");
+    void *sym_translate = graal_runtime_sym(&circe_runtime, "circe_sql_translate");
     if (!sym_translate) return;
-    void *sym_render_translate = dlsym(circe_lib_handle, "circe_sql_render_translate");
+    void *sym_render_translate = graal_runtime_sym(&circe_runtime, "circe_sql_render_translate");
     if (!sym_render_translate) return;
-    void *sym_check = dlsym(circe_lib_handle, "circe_check_cohort");
+    void *sym_check = graal_runtime_sym(&circe_runtime, "circe_check_cohort");
     if (!sym_check) return;
-    void *sym_create = dlsym(circe_lib_handle, "graal_create_isolate");
-    if (!sym_create) return;
-    void *sym_attach = dlsym(circe_lib_handle, "graal_attach_thread");
-    if (!sym_attach) return;
-    void *sym_detach = dlsym(circe_lib_handle, "graal_detach_thread");
-    if (!sym_detach) return;
-
-    graal_create_isolate_ptr = (graal_create_isolate_fn)sym_create;
-    graal_attach_thread_ptr = (graal_attach_thread_fn)sym_attach;
-    graal_detach_thread_ptr = (graal_detach_thread_fn)sym_detach;
-
-    int rc = graal_create_isolate_ptr(NULL, &circe_isolate, &circe_thread);
-    if (rc != 0 || !circe_thread) return;
 
     circe_convert = (circe_convert_fn)sym_build;
     circe_sql_render = (circe_sql_render_fn)sym_render;
@@ -250,6 +476,59 @@ static int EnsureCirceLoaded() {
     return circe_init_success;
 }
 
+static void* circe_warmup_attach_main(void* arg) {
+    (void)arg;
+    if (!circe_runtime.attach_thread || !circe_runtime.isolate) return NULL;
+    graal_isolatethread_t* thread = NULL;
+    if (circe_runtime.attach_thread(circe_runtime.isolate, &thread) == 0 && thread &&
+        circe_runtime.detach_thread) {
+        circe_runtime.detach_thread(thread);
+    }
+    return NULL;
+}
+
+static void* circe_warmup_main(void* arg) {
+    (void)arg;
+    if (!EnsureCirceLoaded()) {
+        /* Best-effort: the lazy path reports the failure with query context
+         * when circe is actually used. */
+        fprintf(stderr, "circe: eager init failed\n");
+        return NULL;
+    }
+    int attach_count = 0;
+    const char* threads_env = getenv("CIRCE_EAGER_INIT_THREADS");
+    if (threads_env) attach_count = atoi(threads_env);
+    for (int i = 0; i < attach_count; i++) {
+        pthread_t attach_thread;
+        if (pthread_create(&attach_thread, NULL, circe_warmup_attach_main, NULL) == 0) {
+            pthread_join(attach_thread, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* Opt-in eager warmup (CIRCE_EAGER_INIT=1): dlopen of the native image plus
+ * graal_create_isolate costs seconds, and by default the first cohort query
+ * pays it inside execution. With warmup enabled the load runs on a background
+ * thread at extension load time. CIRCE_EAGER_INIT_THREADS additionally
+ * pre-attaches that many isolate threads (attach, then detach), priming the
+ * isolate's per-thread setup so the first wave of query threads attaches at
+ * steady-state cost. */
+void StartCirceWarmup(void) {
+    const char* eager = getenv("CIRCE_EAGER_INIT");
+    if (!eager || *eager == '\0' || *eager == '0') {
+        return;
+    }
+    pthread_t warmup_thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&warmup_thread, &attr, circe_warmup_main, NULL) != 0) {
+        fprintf(stderr, "circe: failed to start warmup thread\n");
+    }
+    pthread_attr_destroy(&attr);
+}
+
 static char* get_string_from_vector(duckdb_vector vector, idx_t row) {
     duckdb_string_t *string_data = (duckdb_string_t*)duckdb_vector_get_data(vector);
     duckdb_string_t str = string_data[row];
@@ -374,7 +653,10 @@ static void CirceJsonToSqlFunction(duckdb_function_info info, duckdb_data_chunk
         duckdb_vector_ensure_validity_writable(output);
         result_validity = duckdb_vector_get_validity(output);
     }
-    
+
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if ((b64_validity && !duckdb_validity_row_is_valid(b64_validity, row)) ||
             (opts_validity && !duckdb_validity_row_is_valid(opts_validity, row))) {
@@ -383,38 +665,58 @@ static void CirceJsonToSqlFunction(duckdb_function_info info, duckdb_data_chunk
             }
             continue;
         }
-        
+
         char* b64_expr = get_string_from_vector(b64_vector, row);
         char* opts = get_string_from_vector(opts_vector, row);
-        
+
         if (!b64_expr || !opts) {
             set_error_in_vector(output, row, result_validity);
             if (b64_expr) duckdb_free(b64_expr);
             if (opts) duckdb_free(opts);
             continue;
         }
-        
+
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_BUILD_SQL, b64_expr, opts, NULL, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(b64_expr);
+                duckdb_free(opts);
+                continue;
+            }
+        }
+
         size_t decoded_len;
         char* decoded = base64_decode(b64_expr, strlen(b64_expr), &decoded_len);
         if (!decoded || decoded_len == 0) {
             duckdb_scalar_function_set_error(info, "circe_json_to_sql: base64 decode failed");
             if (decoded) duckdb_free(decoded);
+            free(key);
             duckdb_free(b64_expr);
             duckdb_free(opts);
+            circe_chunk_memo_destroy(&memo);
             return;
         }
-        
-        char* sql_c = circe_run_with_large_stack(CIRCE_OP_BUILD_SQL, decoded, opts, NULL);
+
+        char* sql_c = circe_run_op(CIRCE_OP_BUILD_SQL, decoded, opts, NULL);
         if (sql_c) {
             set_string_in_vector(output, row, sql_c);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, sql_c);
+            free(sql_c);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(decoded);
         duckdb_free(b64_expr);
         duckdb_free(opts);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void CirceSqlRenderFunction(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -439,7 +741,10 @@ static void CirceSqlRenderFunction(duckdb_function_info info, duckdb_data_chunk
         duckdb_vector_ensure_validity_writable(output);
         result_validity = duckdb_vector_get_validity(output);
     }
-    
+
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if ((template_validity && !duckdb_validity_row_is_valid(template_validity, row)) ||
             (params_validity && !duckdb_validity_row_is_valid(params_validity, row))) {
@@ -448,27 +753,45 @@ static void CirceSqlRenderFunction(duckdb_function_info info, duckdb_data_chunk
             }
             continue;
         }
-        
+
         char* template_str = get_string_from_vector(template_vector, row);
         char* params_str = get_string_from_vector(params_vector, row);
-        
+
         if (!template_str || !params_str) {
             set_error_in_vector(output, row, result_validity);
             if (template_str) duckdb_free(template_str);
             if (params_str) duckdb_free(params_str);
             continue;
         }
-        
-        char* rendered_c = circe_run_with_large_stack(CIRCE_OP_SQL_RENDER, template_str, params_str, NULL);
+
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_SQL_RENDER, template_str, params_str, NULL, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(template_str);
+                duckdb_free(params_str);
+                continue;
+            }
+        }
+
+        char* rendered_c = circe_run_op(CIRCE_OP_SQL_RENDER, template_str, params_str, NULL);
         if (rendered_c) {
             set_string_in_vector(output, row, rendered_c);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, rendered_c);
+            free(rendered_c);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(template_str);
         duckdb_free(params_str);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void CirceSqlTranslateFunction(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -493,7 +816,10 @@ static void CirceSqlTranslateFunction(duckdb_function_info info, duckdb_data_chu
         duckdb_vector_ensure_validity_writable(output);
         result_validity = duckdb_vector_get_validity(output);
     }
-    
+
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if ((sql_validity && !duckdb_validity_row_is_valid(sql_validity, row)) ||
             (dialect_validity && !duckdb_validity_row_is_valid(dialect_validity, row))) {
@@ -502,27 +828,45 @@ static void CirceSqlTranslateFunction(duckdb_function_info info, duckdb_data_chu
             }
             continue;
         }
-        
+
         char* sql_str = get_string_from_vector(sql_vector, row);
         char* dialect_str = get_string_from_vector(dialect_vector, row);
-        
+
         if (!sql_str || !dialect_str) {
             set_error_in_vector(output, row, result_validity);
             if (sql_str) duckdb_free(sql_str);
             if (dialect_str) duckdb_free(dialect_str);
             continue;
         }
-        
-        char* translated_c = circe_run_with_large_stack(CIRCE_OP_SQL_TRANSLATE, sql_str, dialect_str, NULL);
+
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_SQL_TRANSLATE, sql_str, dialect_str, NULL, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(sql_str);
+                duckdb_free(dialect_str);
+                continue;
+            }
+        }
+
+        char* translated_c = circe_run_op(CIRCE_OP_SQL_TRANSLATE, sql_str, dialect_str, NULL);
         if (translated_c) {
             set_string_in_vector(output, row, translated_c);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, translated_c);
+            free(translated_c);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(sql_str);
         duckdb_free(dialect_str);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void CirceSqlRenderTranslateFunction(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -549,7 +893,10 @@ static void CirceSqlRenderTranslateFunction(duckdb_function_info info, duckdb_da
         duckdb_vector_ensure_validity_writable(output);
         result_validity = duckdb_vector_get_validity(output);
     }
-    
+
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if ((template_validity && !duckdb_validity_row_is_valid(template_validity, row)) ||
             (dialect_validity && !duckdb_validity_row_is_valid(dialect_validity, row)) ||
@@ -559,11 +906,11 @@ static void CirceSqlRenderTranslateFunction(duckdb_function_info info, duckdb_da
             }
             continue;
         }
-        
+
         char* template_str = get_string_from_vector(template_vector, row);
         char* dialect_str = get_string_from_vector(dialect_vector, row);
         char* params_str = get_string_from_vector(params_vector, row);
-        
+
         if (!template_str || !dialect_str || !params_str) {
             set_error_in_vector(output, row, result_validity);
             if (template_str) duckdb_free(template_str);
@@ -571,18 +918,37 @@ static void CirceSqlRenderTranslateFunction(duckdb_function_info info, duckdb_da
             if (params_str) duckdb_free(params_str);
             continue;
         }
-        
-        char* result_c = circe_run_with_large_stack(CIRCE_OP_SQL_RENDER_TRANSLATE, template_str, dialect_str, params_str);
+
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_SQL_RENDER_TRANSLATE, template_str, dialect_str, params_str, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(template_str);
+                duckdb_free(dialect_str);
+                duckdb_free(params_str);
+                continue;
+            }
+        }
+
+        char* result_c = circe_run_op(CIRCE_OP_SQL_RENDER_TRANSLATE, template_str, dialect_str, params_str);
         if (result_c) {
             set_string_in_vector(output, row, result_c);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, result_c);
+            free(result_c);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(template_str);
         duckdb_free(dialect_str);
         duckdb_free(params_str);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void CirceGenerateAndTranslateFunction(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -607,7 +973,10 @@ static void CirceGenerateAndTranslateFunction(duckdb_function_info info, duckdb_
         duckdb_vector_ensure_validity_writable(output);
         result_validity = duckdb_vector_get_validity(output);
     }
-    
+
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if ((b64_validity && !duckdb_validity_row_is_valid(b64_validity, row)) ||
             (opts_validity && !duckdb_validity_row_is_valid(opts_validity, row))) {
@@ -616,47 +985,71 @@ static void CirceGenerateAndTranslateFunction(duckdb_function_info info, duckdb_
             }
             continue;
         }
-        
+
         char* b64_expr = get_string_from_vector(b64_vector, row);
         char* opts = get_string_from_vector(opts_vector, row);
-        
+
         if (!b64_expr || !opts) {
             set_error_in_vector(output, row, result_validity);
             if (b64_expr) duckdb_free(b64_expr);
             if (opts) duckdb_free(opts);
             continue;
         }
-        
+
+        // The memo is local to this invocation, so keying on the raw inputs
+        // covers the whole build+translate pipeline.
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_BUILD_SQL, b64_expr, opts, NULL, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(b64_expr);
+                duckdb_free(opts);
+                continue;
+            }
+        }
+
         size_t decoded_len;
         char* decoded = base64_decode(b64_expr, strlen(b64_expr), &decoded_len);
         if (!decoded || decoded_len == 0) {
             duckdb_scalar_function_set_error(info, "circe_generate_and_translate: base64 decode failed");
             if (decoded) duckdb_free(decoded);
+            free(key);
             duckdb_free(b64_expr);
             duckdb_free(opts);
+            circe_chunk_memo_destroy(&memo);
             return;
         }
-        
-        char* sql_c = circe_run_with_large_stack(CIRCE_OP_BUILD_SQL, decoded, opts, NULL);
+
+        char* sql_c = circe_run_op(CIRCE_OP_BUILD_SQL, decoded, opts, NULL);
         duckdb_free(decoded);
 
         if (!sql_c) {
             set_error_in_vector(output, row, result_validity);
+            free(key);
             duckdb_free(b64_expr);
             duckdb_free(opts);
             continue;
         }
 
-        char* translated_sql = circe_run_with_large_stack(CIRCE_OP_SQL_TRANSLATE, sql_c, "duckdb", NULL);
+        char* translated_sql = circe_run_op(CIRCE_OP_SQL_TRANSLATE, sql_c, "duckdb", NULL);
+        free(sql_c);
         if (translated_sql) {
             set_string_in_vector(output, row, translated_sql);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, translated_sql);
+            free(translated_sql);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(b64_expr);
         duckdb_free(opts);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void CirceCheckCohortFunction(duckdb_function_info info, duckdb_data_chunk input, duckdb_vector output) {
@@ -680,6 +1073,9 @@ static void CirceCheckCohortFunction(duckdb_function_info info, duckdb_data_chun
         result_validity = duckdb_vector_get_validity(output);
     }
 
+    circe_chunk_memo_t memo;
+    circe_chunk_memo_init(&memo, input_size);
+
     for (idx_t row = 0; row < input_size; row++) {
         if (b64_validity && !duckdb_validity_row_is_valid(b64_validity, row)) {
             if (result_validity) {
@@ -695,25 +1091,44 @@ static void CirceCheckCohortFunction(duckdb_function_info info, duckdb_data_chun
             continue;
         }
 
+        size_t key_len = 0;
+        char* key = circe_memo_make_key(CIRCE_OP_CHECK_COHORT, b64_expr, NULL, NULL, &key_len);
+        if (key) {
+            const char* hit = circe_chunk_memo_lookup(&memo, key, key_len);
+            if (hit) {
+                set_string_in_vector(output, row, hit);
+                free(key);
+                duckdb_free(b64_expr);
+                continue;
+            }
+        }
+
         size_t decoded_len;
         char* decoded = base64_decode(b64_expr, strlen(b64_expr), &decoded_len);
         if (!decoded || decoded_len == 0) {
             duckdb_scalar_function_set_error(info, "circe_check_cohort: base64 decode failed");
             if (decoded) duckdb_free(decoded);
+            free(key);
             duckdb_free(b64_expr);
+            circe_chunk_memo_destroy(&memo);
             return;
         }
 
-        char* warnings_json = circe_run_with_large_stack(CIRCE_OP_CHECK_COHORT, decoded, NULL, NULL);
+        char* warnings_json = circe_run_op(CIRCE_OP_CHECK_COHORT, decoded, NULL, NULL);
         if (warnings_json) {
             set_string_in_vector(output, row, warnings_json);
+            if (key) circe_chunk_memo_remember(&memo, key, key_len, warnings_json);
+            free(warnings_json);
         } else {
             set_error_in_vector(output, row, result_validity);
         }
 
+        free(key);
         duckdb_free(decoded);
         duckdb_free(b64_expr);
     }
+
+    circe_chunk_memo_destroy(&memo);
 }
 
 static void register_scalar_alias(duckdb_connection connection, const char *alias,
@@ -857,3 +1272,71 @@ void RegisterCirceCheckCohortFunction(duckdb_connection connection) {
     // Deprecated alias for external consumers
     register_scalar_alias(connection, "circe_check_cohort", CirceCheckCohortFunction, 1);
 }
+
+/* trex_atlas_trace(): streams the trace ring's recent spans as
+ * (span, start_ns, duration_ns, thread_id) rows for SQL aggregation. The
+ * snapshot is taken once at init; the function call streams it out. */
+typedef struct {
+    trace_ring_span_t* spans;
+    size_t count;
+    size_t next;
+} circe_trace_state_t;
+
+static void circe_trace_state_destroy(void* ptr) {
+    circe_trace_state_t* state = (circe_trace_state_t*)ptr;
+    if (state) {
+        free(state->spans);
+        free(state);
+    }
+}
+
+static void CirceTraceBind(duckdb_bind_info info) {
+    duckdb_logical_type varchar_type = duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR);
+    duckdb_logical_type bigint_type = duckdb_create_logical_type(DUCKDB_TYPE_BIGINT);
+    duckdb_bind_add_result_column(info, "span", varchar_type);
+    duckdb_bind_add_result_column(info, "start_ns", bigint_type);
+    duckdb_bind_add_result_column(info, "duration_ns", bigint_type);
+    duckdb_bind_add_result_column(info, "thread_id", bigint_type);
+    duckdb_destroy_logical_type(&bigint_type);
+    duckdb_destroy_logical_type(&varchar_type);
+}
+
+static void CirceTraceInit(duckdb_init_info info) {
+    circe_trace_state_t* state = (circe_trace_state_t*)malloc(sizeof(circe_trace_state_t));
+    state->spans = trace_ring_snapshot(&state->count);
+    state->next = 0;
+    duckdb_init_set_init_data(info, state, circe_trace_state_destroy);
+}
+
+static void CirceTraceFunction(duckdb_function_info info, duckdb_data_chunk output) {
+    circe_trace_state_t* state = (circe_trace_state_t*)duckdb_function_get_init_data(info);
+
+    duckdb_vector span_vector = duckdb_data_chunk_get_vector(output, 0);
+    int64_t* start_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 1));
+    int64_t* duration_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 2));
+    int64_t* thread_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 3));
+
+    idx_t capacity = duckdb_vector_size();
+    idx_t row = 0;
+    while (row < capacity && state->next < state->count) {
+        trace_ring_span_t* src = &state->spans[state->next];
+        duckdb_vector_assign_string_element(span_vector, row, src->span ? src->span : "");
+        start_data[row] = (int64_t)src->start_ns;
+        duration_data[row] = (int64_t)src->duration_ns;
+        thread_data[row] = (int64_t)src->thread_id;
+        row++;
+        state->next++;
+    }
+
+    duckdb_data_chunk_set_size(output, row);
+}
+
+void RegisterCirceTraceFunction(duckdb_connection connection) {
+    duckdb_table_function function = duckdb_create_table_function();
+    duckdb_table_function_set_name(function, "trex_atlas_trace");
+    duckdb_table_function_set_bind(function, CirceTraceBind);
+    duckdb_table_function_set_init(function, CirceTraceInit);
+    duckdb_table_function_set_function(function, CirceTraceFunction);
+    duckdb_register_table_function(connection, function);
+    duckdb_destroy_table_function(&function);
+}
@@ -10,3 +10,5 @@ void RegisterCirceSqlTranslateFunction(duckdb_connection connection);
 void RegisterCirceSqlRenderTranslateFunction(duckdb_connection connection);
 void RegisterCirceGenerateAndTranslateFunction(duckdb_connection connection);
 void RegisterCirceCheckCohortFunction(duckdb_connection connection);
+void RegisterCirceTraceFunction(duckdb_connection connection);
+void StartCirceWarmup(void);
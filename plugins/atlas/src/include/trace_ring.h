@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lightweight span tracing for extension hot paths. Each thread records into
+ * its own fixed-size ring, so the record path is a monotonic clock read and a
+ * few plain stores - no locks and no allocation after a thread's first span.
+ * Rings are registered on a global list the first time a thread records and
+ * live for the process lifetime; a snapshot walks the list and copies out the
+ * retained spans of every thread. A reader can race a writer on a wrapping
+ * ring; a torn slot shows up as one bogus row of diagnostics, an acceptable
+ * trade for keeping the hot path synchronization-free.
+ *
+ * Span names must be string literals (or otherwise immortal): the ring stores
+ * the pointer, not a copy.
+ *
+ * Vendored identically into the ai, atlas, and cql2elm plugins; keep the
+ * copies in sync. */
+
+typedef struct {
+    const char *span;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint64_t thread_id;
+} trace_ring_span_t;
+
+/* Monotonic nanoseconds; pair with trace_ring_record around a hot section. */
+uint64_t trace_ring_now_ns(void);
+
+/* Records one span ending now; start_ns comes from trace_ring_now_ns. */
+void trace_ring_record(const char *span, uint64_t start_ns);
+
+/* Copies every thread's retained spans into one malloc'd array the caller
+ * frees; *out_count receives the span count. NULL when nothing was recorded. */
+trace_ring_span_t *trace_ring_snapshot(size_t *out_count);
+
+#ifdef __cplusplus
+}
+#endif
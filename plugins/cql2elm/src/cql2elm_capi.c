@@ -5,5 +5,7 @@ DUCKDB_EXTENSION_EXTERN
 
 DUCKDB_EXTENSION_ENTRYPOINT(duckdb_connection connection, duckdb_extension_info info, struct duckdb_extension_access *access) {
     RegisterCql2ElmTranslateFunction(connection);
+    RegisterCql2ElmTranslateBulkFunction(connection);
+    RegisterCql2ElmTraceFunction(connection);
     return true;
 }
@@ -1,152 +1,256 @@
 #include "duckdb_extension.h"
 #include "cql2elm_functions.h"
-#include <dlfcn.h>
+#include "graal_runtime.h"
+#include "trace_ring.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <pthread.h>
-#include <errno.h>
-
-#ifdef CQL2ELM_EMBEDDED_NATIVE_LIB
+#include <ctype.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+
+#ifdef CQL2ELM_EMBEDDED_NATIVE_LIB
 #include "cql2elm_native_embedded.h"
 #endif
 
 #define CQL2ELM_WORKER_STACK_SIZE (16 * 1024 * 1024)
 
-DUCKDB_EXTENSION_EXTERN
+/* Pool sizing: translating a measure bundle dispatches independent libraries
+ * concurrently across the runtime's pre-attached isolate threads. */
+#define CQL2ELM_WORKER_POOL_SIZE 4
 
-typedef struct graal_isolate graal_isolate_t;
-typedef struct graal_isolatethread graal_isolatethread_t;
+DUCKDB_EXTENSION_EXTERN
 
 typedef char *(*cql2elm_translate_fn)(graal_isolatethread_t *, char *cql_text);
-typedef int (*graal_create_isolate_fn)(void *params, graal_isolate_t **isolate, graal_isolatethread_t **thread);
-typedef int (*graal_attach_thread_fn)(graal_isolate_t *isolate, graal_isolatethread_t **thread);
-typedef int (*graal_detach_thread_fn)(graal_isolatethread_t *thread);
 
-static void *cql2elm_lib_handle = NULL;
-static graal_isolate_t *cql2elm_isolate = NULL;
-static graal_isolatethread_t *cql2elm_thread = NULL;
+static graal_runtime_t cql2elm_runtime;
 static cql2elm_translate_fn cql2elm_translate = NULL;
-static graal_create_isolate_fn graal_create_isolate_ptr = NULL;
-static graal_attach_thread_fn graal_attach_thread_ptr = NULL;
-static graal_detach_thread_fn graal_detach_thread_ptr = NULL;
 
 static pthread_once_t cql2elm_init_once = PTHREAD_ONCE_INIT;
 static int cql2elm_init_success = 0;
 
-typedef struct {
-    char* cql_text;
-    char* result;
-} cql2elm_work_t;
-
-static void* cql2elm_worker_thread(void* arg) {
-    cql2elm_work_t* work = (cql2elm_work_t*)arg;
+/* Op callback for the shared runtime: returns the raw Graal buffer, which the
+ * runtime copies into caller-owned malloc memory and releases on the worker
+ * thread that produced it. */
+static char* cql2elm_translate_op(graal_isolatethread_t* thread, void* ctx) {
+    uint64_t trace_start = trace_ring_now_ns();
+    char* raw = cql2elm_translate(thread, (char*)ctx);
+    trace_ring_record("cql_translate", trace_start);
+    return raw;
+}
 
-    graal_isolatethread_t* thread = NULL;
-    if (graal_attach_thread_ptr(cql2elm_isolate, &thread) != 0 || !thread) {
-        work->result = NULL;
-        return NULL;
+/* Two-tier translation cache. Translation is a pure function of the CQL text
+ * and takes seconds per library through the Graal translator, while the
+ * libraries themselves change rarely - the same text was re-translated on
+ * every server restart and every test run. Tier one is an in-memory LRU keyed
+ * by the full CQL text (no collision risk), bounded by total bytes. Tier two,
+ * enabled by pointing CQL2ELM_CACHE_DIR at a writable directory, stores the
+ * ELM JSON under an FNV-1a hash of the text so translations survive process
+ * restarts. */
+#define CQL2ELM_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+typedef struct cql2elm_cache_entry {
+    char* key;
+    char* value;
+    struct cql2elm_cache_entry* prev;
+    struct cql2elm_cache_entry* next;
+} cql2elm_cache_entry_t;
+
+static pthread_mutex_t cql2elm_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cql2elm_cache_entry_t* cql2elm_cache_head = NULL;
+static cql2elm_cache_entry_t* cql2elm_cache_tail = NULL;
+static size_t cql2elm_cache_bytes = 0;
+
+static uint64_t cql2elm_text_hash(const char* text) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
     }
+    return hash;
+}
 
-    work->result = cql2elm_translate(thread, work->cql_text);
-    if (graal_detach_thread_ptr(thread) != 0) {
-        fprintf(stderr, "cql2elm: graal_detach_thread failed\n");
-    }
-    return NULL;
+static void cql2elm_cache_unlink(cql2elm_cache_entry_t* entry) {
+    if (entry->prev) entry->prev->next = entry->next; else cql2elm_cache_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev; else cql2elm_cache_tail = entry->prev;
+    entry->prev = NULL;
+    entry->next = NULL;
 }
 
-static char* cql2elm_run_with_large_stack(char* cql_text) {
-    cql2elm_work_t work = {cql_text, NULL};
-    pthread_t thread;
-    pthread_attr_t attr;
+static void cql2elm_cache_push_front(cql2elm_cache_entry_t* entry) {
+    entry->next = cql2elm_cache_head;
+    if (cql2elm_cache_head) cql2elm_cache_head->prev = entry;
+    cql2elm_cache_head = entry;
+    if (!cql2elm_cache_tail) cql2elm_cache_tail = entry;
+}
 
-    if (pthread_attr_init(&attr) != 0) {
-        /* Fallback: run on current thread */
-        graal_isolatethread_t* t = NULL;
-        if (graal_attach_thread_ptr(cql2elm_isolate, &t) == 0 && t) {
-            char* r = cql2elm_translate(t, cql_text);
-            graal_detach_thread_ptr(t);
-            return r;
+/* Returns a malloc'd copy the caller owns, NULL on miss. */
+static char* cql2elm_cache_lookup(const char* key) {
+    pthread_mutex_lock(&cql2elm_cache_mutex);
+    for (cql2elm_cache_entry_t* entry = cql2elm_cache_head; entry; entry = entry->next) {
+        if (strcmp(entry->key, key) == 0) {
+            if (entry != cql2elm_cache_head) {
+                cql2elm_cache_unlink(entry);
+                cql2elm_cache_push_front(entry);
+            }
+            char* copy = strdup(entry->value);
+            pthread_mutex_unlock(&cql2elm_cache_mutex);
+            return copy;
         }
-        return NULL;
     }
+    pthread_mutex_unlock(&cql2elm_cache_mutex);
+    return NULL;
+}
 
-    if (pthread_attr_setstacksize(&attr, CQL2ELM_WORKER_STACK_SIZE) != 0) {
-        pthread_attr_destroy(&attr);
-        return NULL;
+static void cql2elm_cache_store(const char* key, const char* value) {
+    size_t bytes = strlen(key) + strlen(value) + sizeof(cql2elm_cache_entry_t);
+    if (bytes > CQL2ELM_CACHE_MAX_BYTES) return;
+
+    cql2elm_cache_entry_t* entry = (cql2elm_cache_entry_t*)malloc(sizeof(cql2elm_cache_entry_t));
+    if (!entry) return;
+    entry->key = strdup(key);
+    entry->value = strdup(value);
+    if (!entry->key || !entry->value) {
+        free(entry->key);
+        free(entry->value);
+        free(entry);
+        return;
     }
-
-    if (pthread_create(&thread, &attr, cql2elm_worker_thread, &work) != 0) {
-        pthread_attr_destroy(&attr);
-        return NULL;
+    entry->prev = NULL;
+    entry->next = NULL;
+
+    pthread_mutex_lock(&cql2elm_cache_mutex);
+    cql2elm_cache_push_front(entry);
+    cql2elm_cache_bytes += bytes;
+    while (cql2elm_cache_bytes > CQL2ELM_CACHE_MAX_BYTES && cql2elm_cache_tail && cql2elm_cache_tail != cql2elm_cache_head) {
+        cql2elm_cache_entry_t* victim = cql2elm_cache_tail;
+        cql2elm_cache_unlink(victim);
+        cql2elm_cache_bytes -= strlen(victim->key) + strlen(victim->value) + sizeof(cql2elm_cache_entry_t);
+        free(victim->key);
+        free(victim->value);
+        free(victim);
     }
+    pthread_mutex_unlock(&cql2elm_cache_mutex);
+}
 
-    int rc;
-    while ((rc = pthread_join(thread, NULL)) == EINTR) {
-    }
-    pthread_attr_destroy(&attr);
-    return work.result;
+static int cql2elm_disk_cache_path(const char* cql_text, char* path, size_t path_len) {
+    const char* dir = getenv("CQL2ELM_CACHE_DIR");
+    if (!dir || !*dir) return 0;
+    snprintf(path, path_len, "%s/%016llx.elm.json", dir,
+             (unsigned long long)cql2elm_text_hash(cql_text));
+    return 1;
 }
 
-#ifdef CQL2ELM_EMBEDDED_NATIVE_LIB
-static void *LoadEmbeddedCql2ElmLibrary() {
-    if (!cql2elm_native_blob || cql2elm_native_blob_len == 0) return NULL;
-    char tmpl[] = "/tmp/cql2elm-native-XXXXXX.so";
-    int fd = mkstemps(tmpl, 3);
+/* Returns malloc'd file contents, NULL on miss or read error. */
+static char* cql2elm_disk_cache_read(const char* path) {
+    int fd = open(path, O_RDONLY);
     if (fd < 0) return NULL;
-    size_t remaining = cql2elm_native_blob_len;
-    const unsigned char *ptr = cql2elm_native_blob;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    char* buf = (char*)malloc((size_t)st.st_size + 1);
+    if (!buf) {
+        close(fd);
+        return NULL;
+    }
+    size_t remaining = (size_t)st.st_size;
+    char* p = buf;
     while (remaining > 0) {
-        ssize_t w = write(fd, ptr, remaining);
-        if (w <= 0) { close(fd); unlink(tmpl); return NULL; }
-        ptr += w; remaining -= w;
+        ssize_t r = read(fd, p, remaining);
+        if (r <= 0) {
+            close(fd);
+            free(buf);
+            return NULL;
+        }
+        p += r;
+        remaining -= r;
     }
-    fsync(fd);
-    void *handle = dlopen(tmpl, RTLD_LAZY | RTLD_LOCAL);
-    unlink(tmpl);
     close(fd);
-    return handle;
+    buf[st.st_size] = '\0';
+    return buf;
 }
-#endif
 
-static void Cql2ElmInitOnce(void) {
-#ifdef CQL2ELM_EMBEDDED_NATIVE_LIB
-    cql2elm_lib_handle = LoadEmbeddedCql2ElmLibrary();
-#endif
+static void cql2elm_disk_cache_write(const char* path, const char* value) {
+    /* Temp-write-then-rename keeps a concurrent reader from seeing a
+     * half-written file. */
+    char tmp[560];
+    snprintf(tmp, sizeof(tmp), "%s.tmp-%d", path, (int)getpid());
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    size_t remaining = strlen(value);
+    const char* p = value;
+    while (remaining > 0) {
+        ssize_t w = write(fd, p, remaining);
+        if (w <= 0) {
+            close(fd);
+            unlink(tmp);
+            return;
+        }
+        p += w;
+        remaining -= w;
+    }
+    close(fd);
+    if (rename(tmp, path) != 0) {
+        unlink(tmp);
+    }
+}
 
-    if (!cql2elm_lib_handle) {
-        const char *candidates[] = {
-            "./cql2elm-be/native-libs/libcql2elm-native.so",
-            "./cql2elm-be/native-libs/linux-x86_64/libcql2elm-native.so",
-            "libcql2elm-native.so"
-        };
-        for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
-            cql2elm_lib_handle = dlopen(candidates[i], RTLD_LAZY | RTLD_LOCAL);
-            if (cql2elm_lib_handle) break;
+/* Result is always caller-owned malloc memory (cache hit or translate copy);
+ * call sites free() it after copying into the output vector. */
+static char* cql2elm_run_translate(char* cql_text) {
+    char* hit = cql2elm_cache_lookup(cql_text);
+    if (hit) return hit;
+
+    char disk_path[512];
+    int have_disk = cql2elm_disk_cache_path(cql_text, disk_path, sizeof(disk_path));
+    if (have_disk) {
+        char* from_disk = cql2elm_disk_cache_read(disk_path);
+        if (from_disk) {
+            cql2elm_cache_store(cql_text, from_disk);
+            return from_disk;
         }
     }
 
-    if (!cql2elm_lib_handle) return;
+    char* result = graal_runtime_run(&cql2elm_runtime, cql2elm_translate_op, cql_text);
+    /* Translator failures come back as {"error": ...} JSON; never cache those. */
+    if (result && strncmp(result, "{\"error\":", 9) != 0) {
+        cql2elm_cache_store(cql_text, result);
+        if (have_disk) {
+            cql2elm_disk_cache_write(disk_path, result);
+        }
+    }
+    return result;
+}
 
-    void *sym_translate = dlsym(cql2elm_lib_handle, "cql2elm_translate");
+static void Cql2ElmInitOnce(void) {
+    static const char *const candidates[] = {
+        "./cql2elm-be/native-libs/libcql2elm-native.so",
+        "./cql2elm-be/native-libs/linux-x86_64/libcql2elm-native.so",
+        "libcql2elm-native.so"
+    };
+    graal_runtime_config_t config = {
+        .name = "cql2elm",
+#ifdef CQL2ELM_EMBEDDED_NATIVE_LIB
+        .embedded_blob = cql2elm_native_blob,
+        .embedded_blob_len = cql2elm_native_blob_len,
+#else
+        .embedded_blob = NULL,
+        .embedded_blob_len = 0,
+#endif
+        .candidates = candidates,
+        .candidate_count = sizeof(candidates) / sizeof(candidates[0]),
+        .free_result_symbol = "cql2elm_free_result",
+        .worker_count = CQL2ELM_WORKER_POOL_SIZE,
+        .worker_stack_size = CQL2ELM_WORKER_STACK_SIZE
+    };
+    if (!graal_runtime_load(&cql2elm_runtime, &config)) return;
+
+    void *sym_translate = graal_runtime_sym(&cql2elm_runtime, "cql2elm_translate");
     if (!sym_translate) return;
-    void *sym_create = dlsym(cql2elm_lib_handle, "graal_create_isolate");
-    if (!sym_create) return;
-    void *sym_attach = dlsym(cql2elm_lib_handle, "graal_attach_thread");
-    if (!sym_attach) return;
-    void *sym_detach = dlsym(cql2elm_lib_handle, "graal_detach_thread");
-    if (!sym_detach) return;
-
-    graal_create_isolate_ptr = (graal_create_isolate_fn)sym_create;
-    graal_attach_thread_ptr = (graal_attach_thread_fn)sym_attach;
-    graal_detach_thread_ptr = (graal_detach_thread_fn)sym_detach;
-
-    int rc = graal_create_isolate_ptr(NULL, &cql2elm_isolate, &cql2elm_thread);
-    if (rc != 0 || !cql2elm_thread) return;
-
     cql2elm_translate = (cql2elm_translate_fn)sym_translate;
 
     cql2elm_init_success = 1;
@@ -211,14 +315,16 @@ static void Cql2ElmTranslateFunction(duckdb_function_info info, duckdb_data_chun
             continue;
         }
 
-        char* elm_json = cql2elm_run_with_large_stack(cql_text);
+        char* elm_json = cql2elm_run_translate(cql_text);
         if (elm_json) {
             if (strncmp(elm_json, "{\"error\":", 9) == 0) {
                 duckdb_scalar_function_set_error(info, elm_json);
+                free(elm_json);
                 duckdb_free(cql_text);
                 return;
             }
             set_string_in_vector(output, row, elm_json);
+            free(elm_json);
         } else {
             duckdb_scalar_function_set_error(info, "cql_to_elm: translation returned NULL");
             duckdb_free(cql_text);
@@ -242,3 +348,427 @@ void RegisterCql2ElmTranslateFunction(duckdb_connection connection) {
     duckdb_register_scalar_function(connection, function);
     duckdb_destroy_scalar_function(&function);
 }
+
+/* trex_fhir_cql_translate_bulk(names, cql_texts): dependency-ordered parallel
+ * translation of a whole library set. Takes two equal-length VARCHAR lists,
+ * builds the include-dependency DAG between the supplied libraries, and
+ * dispatches every library whose includes are already translated to the
+ * worker pool, so independent libraries translate concurrently across
+ * isolate threads. Rows of (name, elm_json) stream out in completion order;
+ * a library that fails yields its {"error": ...} payload as the row so one
+ * bad library does not hide the other ninety-nine. */
+
+typedef struct {
+    idx_t count;
+    char** names;
+    char** cqls;
+} cql2elm_bulk_bind_t;
+
+#define CQL2ELM_LIB_PENDING 0
+#define CQL2ELM_LIB_RUNNING 1
+#define CQL2ELM_LIB_DONE    2
+
+typedef struct {
+    const cql2elm_bulk_bind_t* bind;
+    int* state;
+    idx_t** deps;            /* per library: indexes of in-batch includes */
+    idx_t* dep_counts;
+    char** results;              /* malloc-owned elm json, NULL on hard failure */
+    graal_runtime_work_t** work; /* heap work item while RUNNING */
+    idx_t* completed;        /* completion order */
+    idx_t completed_count;
+    idx_t emitted;
+    idx_t done_count;
+    int failed;
+} cql2elm_bulk_state_t;
+
+/* Scans CQL text for `include <identifier>` statements and records which of
+ * the batch's libraries they reference. Quoted identifiers are matched with
+ * the quotes stripped; includes that resolve outside the batch (FHIRHelpers
+ * and friends ship with the translator) are ignored. */
+static void cql2elm_collect_deps(cql2elm_bulk_state_t* st, idx_t lib) {
+    const cql2elm_bulk_bind_t* bind = st->bind;
+    const char* text = bind->cqls[lib];
+    st->deps[lib] = bind->count ? (idx_t*)malloc(bind->count * sizeof(idx_t)) : NULL;
+    st->dep_counts[lib] = 0;
+    if (!text || !st->deps[lib]) return;
+
+    for (const char* p = text; (p = strstr(p, "include")) != NULL; p += 7) {
+        if (p != text && !strchr(" \t\r\n", p[-1])) continue;   /* word start */
+        const char* q = p + 7;
+        if (!*q || !strchr(" \t\r\n", *q)) continue;            /* word end */
+        while (*q && strchr(" \t\r\n", *q)) q++;
+
+        const char* name_start;
+        size_t name_len;
+        if (*q == '"') {
+            name_start = ++q;
+            while (*q && *q != '"') q++;
+            name_len = (size_t)(q - name_start);
+        } else {
+            name_start = q;
+            while (*q && (isalnum((unsigned char)*q) || *q == '_' || *q == '.')) q++;
+            name_len = (size_t)(q - name_start);
+        }
+        if (name_len == 0) continue;
+
+        for (idx_t other = 0; other < bind->count; other++) {
+            if (other == lib || !bind->names[other]) continue;
+            if (strlen(bind->names[other]) == name_len &&
+                strncmp(bind->names[other], name_start, name_len) == 0) {
+                /* Record each in-batch dependency once; repeated includes of
+                 * the same library (or stray `include` tokens in comments)
+                 * must not grow past the bind->count-sized buffer. */
+                int seen = 0;
+                for (idx_t d = 0; d < st->dep_counts[lib]; d++) {
+                    if (st->deps[lib][d] == other) {
+                        seen = 1;
+                        break;
+                    }
+                }
+                if (!seen) {
+                    st->deps[lib][st->dep_counts[lib]++] = other;
+                }
+                break;
+            }
+        }
+    }
+}
+
+static int cql2elm_bulk_deps_done(const cql2elm_bulk_state_t* st, idx_t lib) {
+    for (idx_t d = 0; d < st->dep_counts[lib]; d++) {
+        if (st->state[st->deps[lib][d]] != CQL2ELM_LIB_DONE) return 0;
+    }
+    return 1;
+}
+
+static void cql2elm_bulk_mark_done(cql2elm_bulk_state_t* st, idx_t lib, char* result) {
+    st->results[lib] = result;
+    st->state[lib] = CQL2ELM_LIB_DONE;
+    st->completed[st->completed_count++] = lib;
+    st->done_count++;
+}
+
+/* Caches a fresh translation in both tiers; error payloads are never cached. */
+static void cql2elm_bulk_cache_result(const char* cql_text, const char* result) {
+    if (!result || strncmp(result, "{\"error\":", 9) == 0) return;
+    cql2elm_cache_store(cql_text, result);
+    char disk_path[512];
+    if (cql2elm_disk_cache_path(cql_text, disk_path, sizeof(disk_path))) {
+        cql2elm_disk_cache_write(disk_path, result);
+    }
+}
+
+/* Advances the schedule until at least one unemitted completion exists or
+ * everything is done. Returns 0 when the remaining libraries form an include
+ * cycle and no progress is possible. */
+static int cql2elm_bulk_step(cql2elm_bulk_state_t* st) {
+    const cql2elm_bulk_bind_t* bind = st->bind;
+
+    for (;;) {
+        /* Launch phase: start (or cache-complete) every ready library. A
+         * cache hit can unblock dependents, so repeat until a full pass
+         * launches nothing. */
+        int progressed = 1;
+        while (progressed) {
+            progressed = 0;
+            for (idx_t lib = 0; lib < bind->count; lib++) {
+                if (st->state[lib] != CQL2ELM_LIB_PENDING || !cql2elm_bulk_deps_done(st, lib)) {
+                    continue;
+                }
+                char* hit = cql2elm_cache_lookup(bind->cqls[lib]);
+                if (!hit) {
+                    char disk_path[512];
+                    if (cql2elm_disk_cache_path(bind->cqls[lib], disk_path, sizeof(disk_path))) {
+                        hit = cql2elm_disk_cache_read(disk_path);
+                        if (hit) cql2elm_cache_store(bind->cqls[lib], hit);
+                    }
+                }
+                if (hit) {
+                    cql2elm_bulk_mark_done(st, lib, hit);
+                    progressed = 1;
+                    continue;
+                }
+
+                graal_runtime_work_t* work = (graal_runtime_work_t*)malloc(sizeof(graal_runtime_work_t));
+                if (!work) continue;
+                work->op = cql2elm_translate_op;
+                work->ctx = bind->cqls[lib];
+                if (!graal_runtime_submit(&cql2elm_runtime, work)) {
+                    /* No pool: translate here, serially, in dependency order. */
+                    free(work);
+                    char* result = cql2elm_run_translate(bind->cqls[lib]);
+                    cql2elm_bulk_mark_done(st, lib, result);
+                    progressed = 1;
+                    continue;
+                }
+                st->work[lib] = work;
+                st->state[lib] = CQL2ELM_LIB_RUNNING;
+                progressed = 1;
+            }
+        }
+
+        if (st->completed_count > st->emitted || st->done_count == bind->count) {
+            return 1;
+        }
+
+        int running = 0;
+        for (idx_t lib = 0; lib < bind->count; lib++) {
+            if (st->state[lib] == CQL2ELM_LIB_RUNNING) running = 1;
+        }
+        if (!running) {
+            return 0; /* pending libraries wait on each other: include cycle */
+        }
+
+        /* Harvest phase: wait for at least one in-flight translation, then
+         * cache the fresh results (cache hits never pass through here, so
+         * nothing is stored twice). */
+        idx_t harvest_start = st->completed_count;
+        int harvested = 0;
+        pthread_mutex_lock(&cql2elm_runtime.pool_mutex);
+        while (!harvested) {
+            for (idx_t lib = 0; lib < bind->count; lib++) {
+                if (st->state[lib] == CQL2ELM_LIB_RUNNING && st->work[lib]->done) {
+                    char* result = st->work[lib]->result;
+                    free(st->work[lib]);
+                    st->work[lib] = NULL;
+                    cql2elm_bulk_mark_done(st, lib, result);
+                    harvested = 1;
+                }
+            }
+            if (!harvested) {
+                pthread_cond_wait(&cql2elm_runtime.pool_done_cv, &cql2elm_runtime.pool_mutex);
+            }
+        }
+        pthread_mutex_unlock(&cql2elm_runtime.pool_mutex);
+
+        for (idx_t c = harvest_start; c < st->completed_count; c++) {
+            idx_t lib = st->completed[c];
+            cql2elm_bulk_cache_result(bind->cqls[lib], st->results[lib]);
+        }
+    }
+}
+
+static void cql2elm_bulk_bind_destroy(void* ptr) {
+    cql2elm_bulk_bind_t* bind = (cql2elm_bulk_bind_t*)ptr;
+    if (!bind) return;
+    for (idx_t i = 0; i < bind->count; i++) {
+        if (bind->names) duckdb_free(bind->names[i]);
+        if (bind->cqls) duckdb_free(bind->cqls[i]);
+    }
+    free(bind->names);
+    free(bind->cqls);
+    free(bind);
+}
+
+static void cql2elm_bulk_state_destroy(void* ptr) {
+    cql2elm_bulk_state_t* st = (cql2elm_bulk_state_t*)ptr;
+    if (!st) return;
+    /* A cancelled query can leave translations in flight; their work items
+     * live on this state, so wait them out before freeing anything. */
+    pthread_mutex_lock(&cql2elm_runtime.pool_mutex);
+    for (;;) {
+        int running = 0;
+        for (idx_t lib = 0; lib < st->bind->count; lib++) {
+            if (st->state[lib] == CQL2ELM_LIB_RUNNING && !st->work[lib]->done) running = 1;
+        }
+        if (!running) break;
+        pthread_cond_wait(&cql2elm_runtime.pool_done_cv, &cql2elm_runtime.pool_mutex);
+    }
+    pthread_mutex_unlock(&cql2elm_runtime.pool_mutex);
+    for (idx_t lib = 0; lib < st->bind->count; lib++) {
+        if (st->work[lib]) {
+            free(st->work[lib]->result);
+            free(st->work[lib]);
+        }
+        free(st->results[lib]);
+        free(st->deps[lib]);
+    }
+    free(st->state);
+    free(st->deps);
+    free(st->dep_counts);
+    free(st->results);
+    free(st->work);
+    free(st->completed);
+    free(st);
+}
+
+static void Cql2ElmTranslateBulkBind(duckdb_bind_info info) {
+    duckdb_logical_type varchar_type = duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR);
+    duckdb_bind_add_result_column(info, "name", varchar_type);
+    duckdb_bind_add_result_column(info, "elm_json", varchar_type);
+    duckdb_destroy_logical_type(&varchar_type);
+
+    duckdb_value names_value = duckdb_bind_get_parameter(info, 0);
+    duckdb_value cqls_value = duckdb_bind_get_parameter(info, 1);
+    idx_t name_count = duckdb_get_list_size(names_value);
+    idx_t cql_count = duckdb_get_list_size(cqls_value);
+    if (name_count != cql_count) {
+        duckdb_bind_set_error(info, "cql_to_elm_bulk: name and cql lists must have the same length");
+        duckdb_destroy_value(&names_value);
+        duckdb_destroy_value(&cqls_value);
+        return;
+    }
+
+    cql2elm_bulk_bind_t* bind = (cql2elm_bulk_bind_t*)calloc(1, sizeof(cql2elm_bulk_bind_t));
+    bind->count = name_count;
+    bind->names = (char**)calloc(name_count ? name_count : 1, sizeof(char*));
+    bind->cqls = (char**)calloc(name_count ? name_count : 1, sizeof(char*));
+    for (idx_t i = 0; i < name_count; i++) {
+        duckdb_value name_child = duckdb_get_list_child(names_value, i);
+        duckdb_value cql_child = duckdb_get_list_child(cqls_value, i);
+        bind->names[i] = duckdb_get_varchar(name_child);
+        bind->cqls[i] = duckdb_get_varchar(cql_child);
+        duckdb_destroy_value(&name_child);
+        duckdb_destroy_value(&cql_child);
+    }
+    duckdb_destroy_value(&names_value);
+    duckdb_destroy_value(&cqls_value);
+    duckdb_bind_set_bind_data(info, bind, cql2elm_bulk_bind_destroy);
+}
+
+static void Cql2ElmTranslateBulkInit(duckdb_init_info info) {
+    cql2elm_bulk_bind_t* bind = (cql2elm_bulk_bind_t*)duckdb_init_get_bind_data(info);
+    cql2elm_bulk_state_t* st = (cql2elm_bulk_state_t*)calloc(1, sizeof(cql2elm_bulk_state_t));
+    idx_t n = bind->count ? bind->count : 1;
+    st->bind = bind;
+    st->state = (int*)calloc(n, sizeof(int));
+    st->deps = (idx_t**)calloc(n, sizeof(idx_t*));
+    st->dep_counts = (idx_t*)calloc(n, sizeof(idx_t));
+    st->results = (char**)calloc(n, sizeof(char*));
+    st->work = (graal_runtime_work_t**)calloc(n, sizeof(graal_runtime_work_t*));
+    st->completed = (idx_t*)calloc(n, sizeof(idx_t));
+    for (idx_t lib = 0; lib < bind->count; lib++) {
+        cql2elm_collect_deps(st, lib);
+    }
+    duckdb_init_set_init_data(info, st, cql2elm_bulk_state_destroy);
+}
+
+static void Cql2ElmTranslateBulkFunction(duckdb_function_info info, duckdb_data_chunk output) {
+    cql2elm_bulk_state_t* st = (cql2elm_bulk_state_t*)duckdb_function_get_init_data(info);
+    if (st->failed || !st->bind->count) {
+        duckdb_data_chunk_set_size(output, 0);
+        return;
+    }
+    if (!EnsureCql2ElmLoaded()) {
+        duckdb_function_set_error(info, "cql_to_elm_bulk: failed to load cql2elm native library");
+        return;
+    }
+
+    duckdb_vector name_vector = duckdb_data_chunk_get_vector(output, 0);
+    duckdb_vector elm_vector = duckdb_data_chunk_get_vector(output, 1);
+    uint64_t* elm_validity = NULL;
+
+    idx_t capacity = duckdb_vector_size();
+    idx_t row = 0;
+    while (row < capacity) {
+        if (st->emitted == st->completed_count) {
+            if (st->done_count == st->bind->count) break;
+            if (!cql2elm_bulk_step(st)) {
+                st->failed = 1;
+                duckdb_function_set_error(info, "cql_to_elm_bulk: cyclic include dependency between supplied libraries");
+                return;
+            }
+            continue;
+        }
+        idx_t lib = st->completed[st->emitted++];
+        duckdb_vector_assign_string_element(name_vector, row, st->bind->names[lib] ? st->bind->names[lib] : "");
+        if (st->results[lib]) {
+            duckdb_vector_assign_string_element(elm_vector, row, st->results[lib]);
+        } else {
+            if (!elm_validity) {
+                duckdb_vector_ensure_validity_writable(elm_vector);
+                elm_validity = duckdb_vector_get_validity(elm_vector);
+            }
+            duckdb_validity_set_row_invalid(elm_validity, row);
+        }
+        row++;
+    }
+    duckdb_data_chunk_set_size(output, row);
+}
+
+void RegisterCql2ElmTranslateBulkFunction(duckdb_connection connection) {
+    duckdb_table_function function = duckdb_create_table_function();
+    duckdb_table_function_set_name(function, "trex_fhir_cql_translate_bulk");
+
+    duckdb_logical_type varchar_type = duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR);
+    duckdb_logical_type list_type = duckdb_create_list_type(varchar_type);
+    duckdb_table_function_add_parameter(function, list_type);
+    duckdb_table_function_add_parameter(function, list_type);
+    duckdb_destroy_logical_type(&list_type);
+    duckdb_destroy_logical_type(&varchar_type);
+
+    duckdb_table_function_set_bind(function, Cql2ElmTranslateBulkBind);
+    duckdb_table_function_set_init(function, Cql2ElmTranslateBulkInit);
+    duckdb_table_function_set_function(function, Cql2ElmTranslateBulkFunction);
+    duckdb_register_table_function(connection, function);
+    duckdb_destroy_table_function(&function);
+}
+
+/* trex_fhir_cql_trace(): streams the trace ring's recent spans as
+ * (span, start_ns, duration_ns, thread_id) rows for SQL aggregation. The
+ * snapshot is taken once at init; the function call streams it out. */
+typedef struct {
+    trace_ring_span_t* spans;
+    size_t count;
+    size_t next;
+} cql2elm_trace_state_t;
+
+static void cql2elm_trace_state_destroy(void* ptr) {
+    cql2elm_trace_state_t* state = (cql2elm_trace_state_t*)ptr;
+    if (state) {
+        free(state->spans);
+        free(state);
+    }
+}
+
+static void Cql2ElmTraceBind(duckdb_bind_info info) {
+    duckdb_logical_type varchar_type = duckdb_create_logical_type(DUCKDB_TYPE_VARCHAR);
+    duckdb_logical_type bigint_type = duckdb_create_logical_type(DUCKDB_TYPE_BIGINT);
+    duckdb_bind_add_result_column(info, "span", varchar_type);
+    duckdb_bind_add_result_column(info, "start_ns", bigint_type);
+    duckdb_bind_add_result_column(info, "duration_ns", bigint_type);
+    duckdb_bind_add_result_column(info, "thread_id", bigint_type);
+    duckdb_destroy_logical_type(&bigint_type);
+    duckdb_destroy_logical_type(&varchar_type);
+}
+
+static void Cql2ElmTraceInit(duckdb_init_info info) {
+    cql2elm_trace_state_t* state = (cql2elm_trace_state_t*)malloc(sizeof(cql2elm_trace_state_t));
+    state->spans = trace_ring_snapshot(&state->count);
+    state->next = 0;
+    duckdb_init_set_init_data(info, state, cql2elm_trace_state_destroy);
+}
+
+static void Cql2ElmTraceFunction(duckdb_function_info info, duckdb_data_chunk output) {
+    cql2elm_trace_state_t* state = (cql2elm_trace_state_t*)duckdb_function_get_init_data(info);
+
+    duckdb_vector span_vector = duckdb_data_chunk_get_vector(output, 0);
+    int64_t* start_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 1));
+    int64_t* duration_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 2));
+    int64_t* thread_data = (int64_t*)duckdb_vector_get_data(duckdb_data_chunk_get_vector(output, 3));
+
+    idx_t capacity = duckdb_vector_size();
+    idx_t row = 0;
+    while (row < capacity && state->next < state->count) {
+        trace_ring_span_t* src = &state->spans[state->next];
+        duckdb_vector_assign_string_element(span_vector, row, src->span ? src->span : "");
+        start_data[row] = (int64_t)src->start_ns;
+        duration_data[row] = (int64_t)src->duration_ns;
+        thread_data[row] = (int64_t)src->thread_id;
+        row++;
+        state->next++;
+    }
+
+    duckdb_data_chunk_set_size(output, row);
+}
+
+void RegisterCql2ElmTraceFunction(duckdb_connection connection) {
+    duckdb_table_function function = duckdb_create_table_function();
+    duckdb_table_function_set_name(function, "trex_fhir_cql_trace");
+    duckdb_table_function_set_bind(function, Cql2ElmTraceBind);
+    duckdb_table_function_set_init(function, Cql2ElmTraceInit);
+    duckdb_table_function_set_function(function, Cql2ElmTraceFunction);
+    duckdb_register_table_function(connection, function);
+    duckdb_destroy_table_function(&function);
+}
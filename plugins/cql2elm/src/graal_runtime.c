@@ -0,0 +1,281 @@
+#define _GNU_SOURCE
+#include "graal_runtime.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/* Vendored identically into the atlas and cql2elm plugins; keep in sync.
+ * See graal_runtime.h for the module overview. */
+
+static int graal_write_all(int fd, const unsigned char *ptr, size_t remaining) {
+    while (remaining > 0) {
+        ssize_t w = write(fd, ptr, remaining);
+        if (w <= 0) return 0;
+        ptr += w; remaining -= w;
+    }
+    return 1;
+}
+
+/* FNV-1a over the embedded blob: names the on-disk cache file so a rebuilt
+ * library gets a fresh path while identical builds share one extraction. */
+static uint64_t graal_blob_hash(const unsigned char *blob, size_t len) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= blob[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void *graal_load_embedded(const char *name, const unsigned char *blob, size_t blob_len) {
+    if (!blob || blob_len == 0) return NULL;
+
+#ifdef __linux__
+    /* Preferred path: an anonymous in-memory file. The .so never touches
+     * disk, so there is no write-out or fsync stall on slow /tmp. */
+    int mfd = memfd_create(name, MFD_CLOEXEC);
+    if (mfd >= 0) {
+        if (graal_write_all(mfd, blob, blob_len)) {
+            char fd_path[64];
+            snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", mfd);
+            void *handle = dlopen(fd_path, RTLD_LAZY | RTLD_LOCAL);
+            close(mfd);
+            if (handle) return handle;
+        } else {
+            close(mfd);
+        }
+    }
+#endif
+
+    /* Fallback: extraction cached under a content-hash name, so subsequent
+     * process starts dlopen the existing file instead of rewriting the blob. */
+    char cache_path[160];
+    snprintf(cache_path, sizeof(cache_path), "/tmp/%s-native-%016llx.so", name,
+             (unsigned long long)graal_blob_hash(blob, blob_len));
+    void *handle = dlopen(cache_path, RTLD_LAZY | RTLD_LOCAL);
+    if (handle) return handle;
+
+    char tmpl[160];
+    snprintf(tmpl, sizeof(tmpl), "/tmp/%s-native-XXXXXX.so", name);
+    int fd = mkstemps(tmpl, 3);
+    if (fd < 0) return NULL;
+    if (!graal_write_all(fd, blob, blob_len)) {
+        close(fd);
+        unlink(tmpl);
+        return NULL;
+    }
+    fsync(fd);
+    close(fd);
+    if (rename(tmpl, cache_path) != 0) {
+        /* Lost a race (or /tmp is odd); load the temp file directly. */
+        handle = dlopen(tmpl, RTLD_LAZY | RTLD_LOCAL);
+        unlink(tmpl);
+        return handle;
+    }
+    return dlopen(cache_path, RTLD_LAZY | RTLD_LOCAL);
+}
+
+char *graal_runtime_take_result(graal_runtime_t *rt, graal_isolatethread_t *thread, char *raw) {
+    if (!raw) return NULL;
+    char *copy = strdup(raw);
+    /* Without the release every result parks on the isolate heap for the
+     * life of the process. Libraries without a free entry point leak the
+     * original exactly as before the release contract existed. */
+    if (rt->free_result) rt->free_result(thread, raw);
+    return copy;
+}
+
+static void *graal_pool_worker(void *arg) {
+    graal_runtime_t *rt = (graal_runtime_t *)arg;
+    graal_isolatethread_t *thread = NULL;
+    if (rt->attach_thread(rt->isolate, &thread) != 0 || !thread) {
+        fprintf(stderr, "%s: worker failed to attach to isolate\n", rt->name);
+        pthread_mutex_lock(&rt->pool_mutex);
+        rt->pool_workers--;
+        if (rt->pool_workers == 0) {
+            /* Last worker gone: anything accepted while workers still seemed
+             * alive would otherwise never run and its submitter would wait on
+             * pool_done_cv forever. Fail the queue so callers fall back. */
+            for (graal_runtime_work_t *work = rt->pool_head; work; work = work->next) {
+                work->result = NULL;
+                work->done = 1;
+            }
+            rt->pool_head = NULL;
+            rt->pool_tail = NULL;
+            pthread_cond_broadcast(&rt->pool_done_cv);
+        }
+        pthread_mutex_unlock(&rt->pool_mutex);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&rt->pool_mutex);
+    for (;;) {
+        while (!rt->pool_head) {
+            pthread_cond_wait(&rt->pool_work_cv, &rt->pool_mutex);
+        }
+        graal_runtime_work_t *work = rt->pool_head;
+        rt->pool_head = work->next;
+        if (!rt->pool_head) {
+            rt->pool_tail = NULL;
+        }
+        pthread_mutex_unlock(&rt->pool_mutex);
+
+        work->result = graal_runtime_take_result(rt, thread, work->op(thread, work->ctx));
+
+        pthread_mutex_lock(&rt->pool_mutex);
+        work->done = 1;
+        pthread_cond_broadcast(&rt->pool_done_cv);
+    }
+    /* Not reached: workers live for the process lifetime, attached. */
+    return NULL;
+}
+
+static void graal_start_pool(graal_runtime_t *rt, int worker_count) {
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) return;
+    if (pthread_attr_setstacksize(&attr, rt->worker_stack_size) != 0 ||
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0) {
+        pthread_attr_destroy(&attr);
+        return;
+    }
+    for (int i = 0; i < worker_count; i++) {
+        /* Count before create: a worker that fails to attach decrements. */
+        pthread_mutex_lock(&rt->pool_mutex);
+        rt->pool_workers++;
+        pthread_mutex_unlock(&rt->pool_mutex);
+        pthread_t tid;
+        if (pthread_create(&tid, &attr, graal_pool_worker, rt) != 0) {
+            pthread_mutex_lock(&rt->pool_mutex);
+            rt->pool_workers--;
+            pthread_mutex_unlock(&rt->pool_mutex);
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+int graal_runtime_load(graal_runtime_t *rt, const graal_runtime_config_t *config) {
+    memset(rt, 0, sizeof(*rt));
+    rt->name = config->name;
+    rt->worker_stack_size = config->worker_stack_size;
+    pthread_mutex_init(&rt->pool_mutex, NULL);
+    pthread_cond_init(&rt->pool_work_cv, NULL);
+    pthread_cond_init(&rt->pool_done_cv, NULL);
+
+    rt->lib_handle = graal_load_embedded(config->name, config->embedded_blob, config->embedded_blob_len);
+    if (!rt->lib_handle) {
+        for (size_t i = 0; i < config->candidate_count; i++) {
+            rt->lib_handle = dlopen(config->candidates[i], RTLD_LAZY | RTLD_LOCAL);
+            if (rt->lib_handle) break;
+        }
+    }
+    if (!rt->lib_handle) return 0;
+
+    void *sym_create = dlsym(rt->lib_handle, "graal_create_isolate");
+    if (!sym_create) return 0;
+    void *sym_attach = dlsym(rt->lib_handle, "graal_attach_thread");
+    if (!sym_attach) return 0;
+    void *sym_detach = dlsym(rt->lib_handle, "graal_detach_thread");
+    if (!sym_detach) return 0;
+
+    rt->create_isolate = (graal_runtime_create_isolate_fn)sym_create;
+    rt->attach_thread = (graal_runtime_attach_fn)sym_attach;
+    rt->detach_thread = (graal_runtime_detach_fn)sym_detach;
+    if (config->free_result_symbol) {
+        /* Optional: older native libs keep results on the isolate heap. */
+        rt->free_result = (graal_runtime_free_result_fn)dlsym(rt->lib_handle, config->free_result_symbol);
+    }
+
+    int rc = rt->create_isolate(NULL, &rt->isolate, &rt->main_thread);
+    if (rc != 0 || !rt->main_thread) return 0;
+
+    graal_start_pool(rt, config->worker_count);
+    return 1;
+}
+
+void *graal_runtime_sym(graal_runtime_t *rt, const char *symbol) {
+    return rt->lib_handle ? dlsym(rt->lib_handle, symbol) : NULL;
+}
+
+int graal_runtime_submit(graal_runtime_t *rt, graal_runtime_work_t *work) {
+    work->result = NULL;
+    work->done = 0;
+    work->next = NULL;
+    pthread_mutex_lock(&rt->pool_mutex);
+    if (rt->pool_workers == 0) {
+        pthread_mutex_unlock(&rt->pool_mutex);
+        return 0;
+    }
+    if (rt->pool_tail) {
+        rt->pool_tail->next = work;
+    } else {
+        rt->pool_head = work;
+    }
+    rt->pool_tail = work;
+    pthread_cond_signal(&rt->pool_work_cv);
+    pthread_mutex_unlock(&rt->pool_mutex);
+    return 1;
+}
+
+typedef struct {
+    graal_runtime_t *rt;
+    graal_runtime_op_fn op;
+    void *ctx;
+    char *result;
+} graal_oneshot_t;
+
+static void *graal_oneshot_worker(void *arg) {
+    graal_oneshot_t *shot = (graal_oneshot_t *)arg;
+    graal_runtime_t *rt = shot->rt;
+    graal_isolatethread_t *thread = NULL;
+    if (rt->attach_thread(rt->isolate, &thread) != 0 || !thread) {
+        shot->result = NULL;
+        return NULL;
+    }
+    shot->result = graal_runtime_take_result(rt, thread, shot->op(thread, shot->ctx));
+    if (rt->detach_thread(thread) != 0) {
+        fprintf(stderr, "%s: graal_detach_thread failed\n", rt->name);
+    }
+    return NULL;
+}
+
+/* Pre-pool behavior, kept as the fallback: one large-stack thread per call. */
+static char *graal_run_oneshot(graal_runtime_t *rt, graal_runtime_op_fn op, void *ctx) {
+    graal_oneshot_t shot = {rt, op, ctx, NULL};
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (pthread_attr_init(&attr) != 0) {
+        /* Last resort: the isolate's creation thread. */
+        return graal_runtime_take_result(rt, rt->main_thread, op(rt->main_thread, ctx));
+    }
+    if (pthread_attr_setstacksize(&attr, rt->worker_stack_size) != 0 ||
+        pthread_create(&thread, &attr, graal_oneshot_worker, &shot) != 0) {
+        pthread_attr_destroy(&attr);
+        return graal_runtime_take_result(rt, rt->main_thread, op(rt->main_thread, ctx));
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+    return shot.result;
+}
+
+char *graal_runtime_run(graal_runtime_t *rt, graal_runtime_op_fn op, void *ctx) {
+    graal_runtime_work_t work = {op, ctx, NULL, 0, NULL};
+    if (!graal_runtime_submit(rt, &work)) {
+        return graal_run_oneshot(rt, op, ctx);
+    }
+    pthread_mutex_lock(&rt->pool_mutex);
+    while (!work.done) {
+        pthread_cond_wait(&rt->pool_done_cv, &rt->pool_mutex);
+    }
+    pthread_mutex_unlock(&rt->pool_mutex);
+    return work.result;
+}
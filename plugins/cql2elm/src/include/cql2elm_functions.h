@@ -3,3 +3,5 @@
 #include "duckdb_extension.h"
 
 void RegisterCql2ElmTranslateFunction(duckdb_connection connection);
+void RegisterCql2ElmTranslateBulkFunction(duckdb_connection connection);
+void RegisterCql2ElmTraceFunction(duckdb_connection connection);
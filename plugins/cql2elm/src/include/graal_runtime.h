@@ -0,0 +1,93 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* Shared GraalVM native-image runtime used by the circe (atlas) and cql2elm
+ * extensions. One instance manages the native library handle (embedded-blob
+ * loading included), the isolate lifecycle, and a pool of pre-attached
+ * large-stack worker threads; operation results come back as caller-owned
+ * malloc memory, with the isolate-side buffer released through the library's
+ * optional free entry point on the thread that produced it.
+ *
+ * Each extension builds and ships from its own directory (the Docker builds
+ * copy nothing else), so this module is vendored identically into both
+ * plugins. Keep the copies in sync. */
+
+typedef struct graal_isolate graal_isolate_t;
+typedef struct graal_isolatethread graal_isolatethread_t;
+
+/* A result-producing native operation; returns the raw Graal buffer (the
+ * runtime copies it out and releases it). */
+typedef char *(*graal_runtime_op_fn)(graal_isolatethread_t *thread, void *ctx);
+
+typedef struct graal_runtime_work {
+    graal_runtime_op_fn op;
+    void *ctx;
+    char *result; /* caller-owned malloc memory once done is set */
+    int done;
+    struct graal_runtime_work *next;
+} graal_runtime_work_t;
+
+typedef struct graal_runtime_config {
+    const char *name;                   /* file and diagnostic prefix, e.g. "circe" */
+    const unsigned char *embedded_blob; /* optional embedded native image */
+    size_t embedded_blob_len;
+    const char *const *candidates;      /* dlopen fallback paths, tried in order */
+    size_t candidate_count;
+    const char *free_result_symbol;     /* optional result release entry point */
+    int worker_count;
+    size_t worker_stack_size;
+} graal_runtime_config_t;
+
+typedef void (*graal_runtime_free_result_fn)(graal_isolatethread_t *, char *);
+typedef int (*graal_runtime_create_isolate_fn)(void *, graal_isolate_t **, graal_isolatethread_t **);
+typedef int (*graal_runtime_attach_fn)(graal_isolate_t *, graal_isolatethread_t **);
+typedef int (*graal_runtime_detach_fn)(graal_isolatethread_t *);
+
+typedef struct graal_runtime {
+    const char *name;
+    void *lib_handle;
+    graal_isolate_t *isolate;
+    graal_isolatethread_t *main_thread; /* from isolate creation */
+    graal_runtime_create_isolate_fn create_isolate;
+    graal_runtime_attach_fn attach_thread;
+    graal_runtime_detach_fn detach_thread;
+    graal_runtime_free_result_fn free_result;
+    size_t worker_stack_size;
+    /* Worker pool. Submitters wait on pool_done_cv for their work's done
+     * flag, which workers set under pool_mutex and broadcast. Bulk callers
+     * may harvest asynchronously submitted work the same way. */
+    pthread_mutex_t pool_mutex;
+    pthread_cond_t pool_work_cv;
+    pthread_cond_t pool_done_cv;
+    graal_runtime_work_t *pool_head;
+    graal_runtime_work_t *pool_tail;
+    int pool_workers;
+} graal_runtime_t;
+
+/* Loads the native library (embedded blob via memfd or cached extraction,
+ * then the candidate paths), resolves the Graal entry points, creates the
+ * isolate, and starts the worker pool. Returns 1 on success. Not itself
+ * synchronized - both callers sit behind pthread_once. */
+int graal_runtime_load(graal_runtime_t *rt, const graal_runtime_config_t *config);
+
+/* dlsym on the loaded library. */
+void *graal_runtime_sym(graal_runtime_t *rt, const char *symbol);
+
+/* Runs op on a pre-attached pool worker and blocks for the result. Falls
+ * back to a one-shot large-stack thread - or, failing that, the isolate's
+ * creation thread - when no pool worker could start or attach. The returned
+ * string is caller-owned malloc memory; free() it. */
+char *graal_runtime_run(graal_runtime_t *rt, graal_runtime_op_fn op, void *ctx);
+
+/* Asynchronous submission for bulk callers: enqueues work and returns
+ * immediately, 0 when no pool exists (fall back to graal_runtime_run). The
+ * work item must outlive the operation; harvest by locking rt->pool_mutex,
+ * waiting on rt->pool_done_cv, and checking work->done. */
+int graal_runtime_submit(graal_runtime_t *rt, graal_runtime_work_t *work);
+
+/* Copies raw into malloc memory and releases the isolate-side buffer via the
+ * library's free entry point when present. Op callbacks that chain native
+ * calls use this on intermediate results. */
+char *graal_runtime_take_result(graal_runtime_t *rt, graal_isolatethread_t *thread, char *raw);